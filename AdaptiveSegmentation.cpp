@@ -0,0 +1,136 @@
+#include "AdaptiveSegmentation.h"
+
+#include <cmath>
+#include <limits>
+
+#include "PiecewiseLinearInterpolation.h"
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Finds the furthest reading a piece starting at start can reach
+ * without its max error passing the tolerance
+ *
+ * @param times provides the times of the readings
+ * @param temps provides the temps of the readings
+ * @param start index of the first reading of the piece
+ *
+ * @return index of the last reading of the piece
+ */
+std::size_t AdaptiveSegmentation::ExtendMax(std::span<const int> times, std::span<const double> temps, std::size_t start) const {
+	//Range of slopes from the start that stay within tolerance of every reading passed so far
+	double lowest = -std::numeric_limits<double>::infinity();
+	double highest = std::numeric_limits<double>::infinity();
+
+	std::size_t end = start + 1;
+	for (std::size_t next = start + 1; next < times.size(); next++) {
+		double timeOffset = static_cast<double>(times[next]) - times[start];
+		double tempOffset = temps[next] - temps[start];
+		if (timeOffset <= 0.0) {
+			break;
+		}
+
+		double slope = tempOffset / timeOffset;
+		if (slope < lowest || slope > highest) {
+			break;
+		}
+		end = next;
+
+		lowest = std::fmax(lowest, (tempOffset - tolerance) / timeOffset);
+		highest = std::fmin(highest, (tempOffset + tolerance) / timeOffset);
+	}
+	return end;
+}
+
+/**
+ * Finds the furthest reading a piece starting at start can reach
+ * without its RMS error passing the tolerance
+ *
+ * @param times provides the times of the readings
+ * @param temps provides the temps of the readings
+ * @param start index of the first reading of the piece
+ *
+ * @return index of the last reading of the piece
+ */
+std::size_t AdaptiveSegmentation::ExtendRms(std::span<const int> times, std::span<const double> temps, std::size_t start) const {
+	//Sums of u^2, u*v and v^2 with u and v taken from the start of the piece
+	double sumTimeSquares = 0.0;
+	double sumProducts = 0.0;
+	double sumTempSquares = 0.0;
+	double limit = tolerance * tolerance;
+
+	std::size_t end = start + 1;
+	for (std::size_t next = start + 1; next < times.size(); next++) {
+		double timeOffset = static_cast<double>(times[next]) - times[start];
+		double tempOffset = temps[next] - temps[start];
+		if (timeOffset <= 0.0) {
+			break;
+		}
+		sumTimeSquares += timeOffset * timeOffset;
+		sumProducts += timeOffset * tempOffset;
+		sumTempSquares += tempOffset * tempOffset;
+
+		//Sum of (v - slope * u)^2 over the piece, expanded into the sums
+		double slope = tempOffset / timeOffset;
+		double squaredError = sumTempSquares - 2.0 * slope * sumProducts + slope * slope * sumTimeSquares;
+		if (squaredError > limit * (next - start + 1)) {
+			break;
+		}
+		end = next;
+	}
+	return end;
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Sets up a segmentation
+ *
+ * @param tolerance largest error a piece may have (in degrees)
+ * @param errorKind how the error is measured
+ */
+AdaptiveSegmentation::AdaptiveSegmentation(double tolerance, SegmentError errorKind) : tolerance(tolerance), errorKind(errorKind) {
+}
+
+/**
+ * Splits the readings of one core into pieces
+ *
+ * @param times provides list of the times
+ * @param temps provides list of the temps of the target core
+ *
+ * @pre Assumes temps[i] associates with times[i] and times are ascending
+ */
+void AdaptiveSegmentation::Calculate(std::span<const int> times, std::span<const double> temps) {
+	PiecewiseLinearInterpolation interpolationCalculator;
+	knots.clear();
+	slopes.clear();
+	yIntercepts.clear();
+	if (times.size() < 2) {
+		return;
+	}
+
+	//Each piece starts where the last one ended
+	knots.push_back(0);
+	for (std::size_t start = 0; start + 1 < times.size();) {
+		std::size_t end = errorKind == SegmentError::Max ? ExtendMax(times, temps, start) : ExtendRms(times, temps, start);
+		SlopeAndIntercept segment = interpolationCalculator.CalculateSegment(times[start], times[end], temps[start], temps[end]);
+		slopes.push_back(segment.first);
+		yIntercepts.push_back(segment.second);
+		knots.push_back(end);
+		start = end;
+	}
+}
+
+/**
+ * Appends one interpolation line per piece to a report, in the same
+ * format as PiecewiseLinearInterpolation
+ *
+ * @param report formatter to write the lines into
+ * @param times provides the times of the readings passed to Calculate
+ */
+void AdaptiveSegmentation::AppendTo(ReportFormatter& report, std::span<const int> times) const {
+	report.Reserve(slopes.size());
+	for (std::size_t i = 0; i < slopes.size(); i++) {
+		report.AppendInterpolation(times[knots[i]], times[knots[i + 1]], i, yIntercepts[i], slopes[i]);
+	}
+}
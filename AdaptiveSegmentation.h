@@ -0,0 +1,106 @@
+/**
+ * The Adaptive Segmentation class covers the readings of one core with as
+ * few linear pieces as it can while keeping every piece within an error
+ * tolerance. Like the piecewise linear interpolation, each piece runs from
+ * one reading to another; the readings it skips over must lie close to it.
+ *
+ * Pieces are grown greedily from the previous piece's end. The error of a
+ * candidate piece is checked in O(1):
+ *
+ *   - Max error: every skipped reading limits the slopes that pass within
+ *     the tolerance of it, and the candidate's slope must lie inside all of
+ *     those limits.
+ *   - RMS error: running sums of u^2, u*v and v^2 (u and v being the time
+ *     and temp relative to the start of the piece) give the sum of squared
+ *     errors of the candidate line directly.
+ */
+#ifndef ADAPTIVE_SEGMENTATION_H_INCLUDED
+#define ADAPTIVE_SEGMENTATION_H_INCLUDED
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "ReportFormatter.h"
+
+/**
+ * How the error of a piece is measured against the tolerance
+ */
+enum class SegmentError
+{
+	Max, //!< Largest distance of a reading from the piece
+	Rms //!< Root mean square distance of the readings from the piece
+};
+
+class AdaptiveSegmentation
+{
+private:
+
+	double tolerance; //!< Largest error a piece may have
+	SegmentError errorKind; //!< How the error is measured
+
+	std::vector<std::size_t> knots = {}; //!< Index of the reading at each end of a piece (one more than pieces)
+	std::vector<double> slopes = {}; //!< Slope (m) of every piece
+	std::vector<double> yIntercepts = {}; //!< Y-intercept (b) of every piece
+
+	/**
+	 * Finds the furthest reading a piece starting at start can reach
+	 * without its max error passing the tolerance
+	 *
+	 * @param times provides the times of the readings
+	 * @param temps provides the temps of the readings
+	 * @param start index of the first reading of the piece
+	 *
+	 * @return index of the last reading of the piece
+	 */
+	std::size_t ExtendMax(std::span<const int> times, std::span<const double> temps, std::size_t start) const;
+
+	/**
+	 * Finds the furthest reading a piece starting at start can reach
+	 * without its RMS error passing the tolerance
+	 *
+	 * @param times provides the times of the readings
+	 * @param temps provides the temps of the readings
+	 * @param start index of the first reading of the piece
+	 *
+	 * @return index of the last reading of the piece
+	 */
+	std::size_t ExtendRms(std::span<const int> times, std::span<const double> temps, std::size_t start) const;
+
+public:
+
+	/**
+	 * Sets up a segmentation
+	 *
+	 * @param tolerance largest error a piece may have (in degrees)
+	 * @param errorKind how the error is measured
+	 */
+	AdaptiveSegmentation(double tolerance, SegmentError errorKind = SegmentError::Max);
+
+	/**
+	 * Splits the readings of one core into pieces
+	 *
+	 * @param times provides list of the times
+	 * @param temps provides list of the temps of the target core
+	 *
+	 * @pre Assumes temps[i] associates with times[i] and times are ascending
+	 */
+	void Calculate(std::span<const int> times, std::span<const double> temps);
+
+	/**
+	 * Fetches how many pieces the last Calculate produced
+	 *
+	 * @return the number of pieces
+	 */
+	std::size_t GetNumSegments() const { return slopes.size(); }
+
+	/**
+	 * Appends one interpolation line per piece to a report, in the same
+	 * format as PiecewiseLinearInterpolation
+	 *
+	 * @param report formatter to write the lines into
+	 * @param times provides the times of the readings passed to Calculate
+	 */
+	void AppendTo(ReportFormatter& report, std::span<const int> times) const;
+};
+#endif
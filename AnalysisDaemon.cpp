@@ -0,0 +1,651 @@
+#include "AnalysisDaemon.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "BinaryLog.h"
+#include "DataPreProcessor.h"
+#include "InterpolationTable.h"
+#include "LeastSquaresApproximation.h"
+#include "MappedTempParser.h"
+#include "PiecewiseLinearInterpolation.h"
+#include "PipelineArena.h"
+#include "ReportFormatter.h"
+
+/**
+ * Fills in the address of a Unix domain socket
+ *
+ * @param socketPath path of the socket
+ * @param address updated with the address
+ *
+ * @return false if the path is too long for a socket address
+ */
+static bool socketAddress(const std::string& socketPath, sockaddr_un& address) {
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+		return false;
+	}
+	std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+	return true;
+}
+
+/**
+ * Splits a request into words separated by spaces or tabs
+ *
+ * @param request the request line
+ *
+ * @return the words
+ */
+static std::vector<std::string> splitWords(std::string_view request) {
+	std::vector<std::string> words;
+	std::istringstream stream{std::string(request)};
+	std::string word;
+	while (stream >> word) {
+		words.push_back(word);
+	}
+	return words;
+}
+
+/**
+ * Builds a one line response
+ *
+ * @param line the line, without '\n'
+ *
+ * @return the line followed by the empty line ending every response
+ */
+static std::string respond(const std::string& line) {
+	return line + "\n\n";
+}
+
+//Ids start at 1, so an empty worker cache matches no daemon
+static std::atomic<uint64_t> nextInstanceId = 1;
+
+AnalysisDaemon::Connection::~Connection() {
+	if (fd >= 0) {
+		close(fd);
+	}
+}
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Parses a log and fits its models
+ *
+ * @param fileName path of the log (text or binary)
+ * @param unparsable updated with whether the log was read but holds a token that is not a number
+ *
+ * @return the log, nullptr if it could not be read or parsed, or has fewer than two readings
+ */
+std::shared_ptr<const AnalysisDaemon::ResidentLog> AnalysisDaemon::LoadLog(const std::string& fileName, bool& unparsable) {
+	unparsable = false;
+	auto log = std::make_shared<ResidentLog>();
+	log->fileName = fileName;
+	std::error_code error;
+	log->modified = std::filesystem::last_write_time(fileName, error);
+	log->size = std::filesystem::file_size(fileName, error);
+
+	MappedTempParser input_temps(fileName);
+	if (!input_temps.IsOpen()) {
+		return nullptr;
+	}
+	BinaryLog binaryLog(input_temps.Contents());
+	if (BinaryLog::HasMagic(input_temps.Contents()) && !binaryLog.IsValid()) {
+		return nullptr;
+	}
+
+	//The arena only lives while the models are built; the log keeps copies.
+	//A bad token ends this request only, not the daemon.
+	PipelineArena arena;
+	std::optional<DataPreProcessor> parsed;
+	try {
+		if (binaryLog.IsValid()) {
+			parsed.emplace(binaryLog, &arena);
+		}
+		else {
+			parsed.emplace(input_temps.Contents(), 30, &arena);
+		}
+	}
+	catch (const std::invalid_argument&) {
+		unparsable = true;
+		return nullptr;
+	}
+	catch (const std::out_of_range&) {
+		unparsable = true;
+		return nullptr;
+	}
+	const DataPreProcessor& processedData = *parsed;
+	std::span<const int> times = processedData.GetTimes();
+	int numCores = processedData.GetNumCores();
+	if (times.size() < 2 || numCores < 1) {
+		return nullptr;
+	}
+
+	InterpolationTable interpolations(&arena);
+	PiecewiseLinearInterpolation().Calculate(interpolations, processedData);
+	log->coreFits.resize(numCores);
+	LeastSquaresApproximation(&arena).Calculate(log->coreFits, processedData);
+
+	log->numCores = numCores;
+	log->times.assign(times.begin(), times.end());
+	log->interpolants.reserve(numCores);
+	for (int core = 0; core < numCores; core++) {
+		log->interpolants.emplace_back(times, interpolations.GetSlopes(core), interpolations.GetIntercepts(core));
+	}
+	return log;
+}
+
+/**
+ * Fetches the latest snapshot of the resident logs through this
+ * thread's cache, taking the lock only if a snapshot was published since
+ * the last call
+ *
+ * @return the snapshot, valid until this thread calls Snapshot again
+ */
+const AnalysisDaemon::Registry& AnalysisDaemon::Snapshot() const {
+	struct CachedSnapshot
+	{
+		uint64_t instanceId = 0; //!< Daemon the snapshot belongs to
+		uint64_t generation = 0; //!< Generation the snapshot was published as
+		std::shared_ptr<const Registry> registry = {}; //!< The snapshot, kept alive by this thread
+	};
+	static thread_local CachedSnapshot cached;
+
+	//Unchanged generation: no lock and no shared reference count is touched
+	if (cached.instanceId != instanceId || cached.generation != generation.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> guard(loadLock);
+		cached.registry = registry;
+		cached.generation = generation.load(std::memory_order_relaxed);
+		cached.instanceId = instanceId;
+	}
+	return *cached.registry;
+}
+
+/**
+ * Looks up a resident log in this thread's snapshot
+ *
+ * @param fileName path the log was loaded from
+ *
+ * @return the log, nullptr if it is not resident; valid until this thread calls Snapshot again
+ */
+const AnalysisDaemon::ResidentLog* AnalysisDaemon::FindLog(const std::string& fileName) const {
+	const Registry& snapshot = Snapshot();
+	auto found = snapshot.find(fileName);
+	return found == snapshot.end() ? nullptr : found->second.get();
+}
+
+/**
+ * Publishes a new snapshot holding log in place of any older version
+ *
+ * @param log the log to make resident
+ */
+void AnalysisDaemon::StoreLog(std::shared_ptr<const ResidentLog> log) {
+	std::lock_guard<std::mutex> guard(loadLock);
+	auto snapshot = std::make_shared<Registry>(*registry);
+	(*snapshot)[log->fileName] = std::move(log);
+	registry = std::move(snapshot);
+	generation.fetch_add(1, std::memory_order_release);
+}
+
+/**
+ * Answers one request line
+ *
+ * @param request the request, without its '\n'
+ *
+ * @return the response, ending with an empty line
+ */
+std::string AnalysisDaemon::HandleRequest(std::string_view request) {
+	requests++;
+	std::vector<std::string> words = splitWords(request);
+	if (words.empty()) {
+		return respond("ERROR empty request");
+	}
+	if (words[0] == "fit") {
+		return Fit(words);
+	}
+	if (words[0] == "eval") {
+		return Evaluate(words);
+	}
+	if (words[0] == "refresh") {
+		return Refresh(words);
+	}
+	if (words[0] == "stats") {
+		return Stats();
+	}
+	return respond("ERROR unknown request " + words[0]);
+}
+
+/**
+ * Answers "fit LOG": loads the log unless it is resident already
+ *
+ * @param words words of the request
+ *
+ * @return the least-squares line of every core, after a line counting the
+ *         cores and readings
+ */
+std::string AnalysisDaemon::Fit(const std::vector<std::string>& words) {
+	if (words.size() != 2) {
+		return respond("ERROR usage: fit LOG");
+	}
+	const ResidentLog* log = FindLog(words[1]);
+	std::shared_ptr<const ResidentLog> loaded;
+	if (log == nullptr) {
+		bool unparsable;
+		loaded = LoadLog(words[1], unparsable);
+		if (loaded == nullptr) {
+			return respond("ERROR " + words[1] + (unparsable ? " could not be parsed" : " could not be loaded"));
+		}
+		loads++;
+		StoreLog(loaded);
+		log = loaded.get();
+	}
+
+	ReportFormatter report;
+	LeastSquaresApproximation leastSquareCalculator;
+	for (const SlopeAndIntercept& coreFit : log->coreFits) {
+		leastSquareCalculator.AppendTo(report, coreFit, log->times);
+	}
+	return "OK " + std::to_string(log->numCores) + " cores, " + std::to_string(log->times.size()) + " readings\n"
+		+ std::string(report.View()) + "\n";
+}
+
+/**
+ * Answers "eval LOG CORE TIME": both models of a core at one time
+ *
+ * @param words words of the request
+ *
+ * @return the interpolation and the least-squares line evaluated at TIME
+ */
+std::string AnalysisDaemon::Evaluate(const std::vector<std::string>& words) {
+	if (words.size() != 4) {
+		return respond("ERROR usage: eval LOG CORE TIME");
+	}
+	const ResidentLog* log = FindLog(words[1]);
+	if (log == nullptr) {
+		return respond("ERROR " + words[1] + " is not loaded (fit it first)");
+	}
+
+	char* end = nullptr;
+	long core = std::strtol(words[2].c_str(), &end, 10);
+	if (*end != '\0' || core < 0 || core >= log->numCores) {
+		return respond("ERROR core must be between 0 and " + std::to_string(log->numCores - 1));
+	}
+	double time = std::strtod(words[3].c_str(), &end);
+	if (*end != '\0' || !(time >= log->times.front() && time <= log->times.back())) {
+		return respond("ERROR time must be between " + std::to_string(log->times.front()) + " and "
+			+ std::to_string(log->times.back()));
+	}
+
+	//The last interpolation also covers the last reading
+	double interpolated = log->interpolants[core].Evaluate(time);
+	const SlopeAndIntercept& coreFit = log->coreFits[core];
+	double fitted = coreFit.second + coreFit.first * time;
+	evaluations++;
+
+	char line[96];
+	std::snprintf(line, sizeof(line), "OK %.4f %.4f", interpolated, fitted);
+	return respond(line);
+}
+
+/**
+ * Answers "refresh [LOG]": reloads a log, or every resident log, that
+ * changed on disk since it was loaded
+ *
+ * @param words words of the request
+ *
+ * @return how many logs were reloaded
+ */
+std::string AnalysisDaemon::Refresh(const std::vector<std::string>& words) {
+	if (words.size() > 2) {
+		return respond("ERROR usage: refresh [LOG]");
+	}
+	//This thread's snapshot keeps the candidates alive while they are reloaded
+	std::vector<const ResidentLog*> candidates;
+	if (words.size() == 2) {
+		const ResidentLog* log = FindLog(words[1]);
+		if (log == nullptr) {
+			return respond("ERROR " + words[1] + " is not loaded (fit it first)");
+		}
+		candidates.push_back(log);
+	}
+	else {
+		for (const auto& entry : Snapshot()) {
+			candidates.push_back(entry.second.get());
+		}
+	}
+
+	//Queries keep answering from the old version until the new one is published
+	int numRefreshed = 0;
+	for (const ResidentLog* log : candidates) {
+		std::error_code error;
+		std::filesystem::file_time_type modified = std::filesystem::last_write_time(log->fileName, error);
+		std::uintmax_t size = std::filesystem::file_size(log->fileName, error);
+		if (modified == log->modified && size == log->size) {
+			continue;
+		}
+		bool unparsable;
+		std::shared_ptr<const ResidentLog> reloaded = LoadLog(log->fileName, unparsable);
+		if (reloaded == nullptr) {
+			return respond("ERROR " + log->fileName + (unparsable ? " could not be parsed" : " could not be reloaded"));
+		}
+		loads++;
+		StoreLog(reloaded);
+		numRefreshed++;
+	}
+	return respond("OK " + std::to_string(numRefreshed) + " refreshed");
+}
+
+/**
+ * Answers "stats"
+ *
+ * @return counters of the daemon as key=value pairs
+ */
+std::string AnalysisDaemon::Stats() const {
+	const Registry& snapshot = Snapshot();
+	std::size_t numReadings = 0;
+	for (const auto& entry : snapshot) {
+		numReadings += entry.second->times.size() * entry.second->numCores;
+	}
+	double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	char line[256];
+	std::snprintf(line, sizeof(line), "OK logs=%zu readings=%zu requests=%llu loads=%llu evaluations=%llu uptime_seconds=%.3f",
+		snapshot.size(), numReadings, static_cast<unsigned long long>(requests.load()),
+		static_cast<unsigned long long>(loads.load()), static_cast<unsigned long long>(evaluations.load()), uptime);
+	return respond(line);
+}
+
+/**
+ * Accepts every waiting client and adds it to the loop
+ */
+void AnalysisDaemon::AcceptClients() {
+	while (true) {
+		int clientFd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (clientFd < 0) {
+			return;
+		}
+		auto connection = std::make_shared<Connection>();
+		connection->fd = clientFd;
+
+		epoll_event event = {};
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.fd = clientFd;
+		if (epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &event) != 0) {
+			continue;
+		}
+		connections[clientFd] = std::move(connection);
+	}
+}
+
+/**
+ * Reads what a client sent and hands complete requests to a worker
+ *
+ * @param connection the client
+ *
+ * @return false once the client has hung up or misbehaved
+ */
+bool AnalysisDaemon::ReadClient(const std::shared_ptr<Connection>& connection) {
+	char buffer[4096];
+	bool open = true;
+	std::string received;
+	while (true) {
+		ssize_t numRead = read(connection->fd, buffer, sizeof(buffer));
+		if (numRead > 0) {
+			received.append(buffer, numRead);
+			continue;
+		}
+		if (numRead == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+			open = false;
+		}
+		if (numRead == 0 || errno != EINTR) {
+			break;
+		}
+	}
+
+	//Requests already sent are still answered after the client stops writing
+	std::lock_guard<std::mutex> guard(connection->lock);
+	connection->input += received;
+	bool complete = connection->input.find('\n') != std::string::npos;
+	if (!complete && connection->input.size() > MAX_REQUEST_BYTES) {
+		return false;
+	}
+	if (complete && !connection->busy) {
+		connection->busy = true;
+		workers.Submit([this, connection] { AnswerClient(connection); });
+	}
+	return open;
+}
+
+/**
+ * Worker task: answers the complete requests of a client in order until
+ * none are left
+ *
+ * @param connection the client
+ */
+void AnalysisDaemon::AnswerClient(std::shared_ptr<Connection> connection) {
+	while (true) {
+		std::string requestLines;
+		{
+			std::lock_guard<std::mutex> guard(connection->lock);
+			std::size_t lineEnd = connection->input.find_last_of('\n');
+			if (lineEnd == std::string::npos) {
+				connection->busy = false;
+				return;
+			}
+			requestLines.assign(connection->input, 0, lineEnd + 1);
+			connection->input.erase(0, lineEnd + 1);
+		}
+
+		std::string responses;
+		std::string_view remaining = requestLines;
+		while (!remaining.empty()) {
+			std::size_t lineEnd = remaining.find('\n');
+			std::string_view request = remaining.substr(0, lineEnd);
+			if (!request.empty() && request.back() == '\r') {
+				request.remove_suffix(1);
+			}
+			//Nothing one request does may take the daemon down with it
+			try {
+				responses += HandleRequest(request);
+			}
+			catch (const std::exception& error) {
+				responses += respond(std::string("ERROR request failed: ") + error.what());
+			}
+			remaining.remove_prefix(lineEnd + 1);
+		}
+		SendAll(connection->fd, responses);
+	}
+}
+
+/**
+ * Writes all of text to a socket, waiting while its buffer is full
+ *
+ * @param fd the socket
+ * @param text what to send
+ *
+ * @return false if the peer went away
+ */
+bool AnalysisDaemon::SendAll(int fd, std::string_view text) {
+	while (!text.empty()) {
+		ssize_t numSent = send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+		if (numSent > 0) {
+			text.remove_prefix(numSent);
+			continue;
+		}
+		if (numSent < 0 && errno == EINTR) {
+			continue;
+		}
+		if (numSent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			//Give a slow reader a while, but not forever
+			pollfd writable = { fd, POLLOUT, 0 };
+			if (poll(&writable, 1, 10 * POLL_MILLISECONDS) > 0) {
+				continue;
+			}
+		}
+		return false;
+	}
+	return true;
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Sets up a daemon that is not listening yet
+ *
+ * @param socketPath path of the Unix domain socket to serve on
+ * @param numThreads workers answering requests
+ */
+AnalysisDaemon::AnalysisDaemon(const std::string& socketPath, int numThreads)
+	: socketPath(socketPath), instanceId(nextInstanceId++), registry(std::make_shared<const Registry>()), start(std::chrono::steady_clock::now()),
+	workers(numThreads) {
+}
+
+/**
+ * Closes every client and removes the socket
+ */
+AnalysisDaemon::~AnalysisDaemon() {
+	//Workers may still be answering, and they use everything below
+	workers.Wait();
+	connections.clear();
+	if (epollFd >= 0) {
+		close(epollFd);
+	}
+	if (listenFd >= 0) {
+		close(listenFd);
+		unlink(socketPath.c_str());
+	}
+}
+
+/**
+ * Creates the socket. A socket left behind by a daemon that is no longer
+ * running is replaced.
+ *
+ * @return false if the socket could not be created, or another daemon
+ *         is serving on it
+ */
+bool AnalysisDaemon::Listen() {
+	sockaddr_un address;
+	if (!socketAddress(socketPath, address)) {
+		return false;
+	}
+
+	//Only a socket nobody answers on is removed
+	struct stat existing;
+	if (lstat(socketPath.c_str(), &existing) == 0) {
+		std::string response;
+		if (!S_ISSOCK(existing.st_mode) || Request(socketPath, "stats", response)) {
+			return false;
+		}
+		unlink(socketPath.c_str());
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return false;
+	}
+	if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+		close(fd);
+		return false;
+	}
+	listenFd = fd;
+
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = listenFd;
+	return epollFd >= 0 && epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) == 0;
+}
+
+/**
+ * Answers requests until keepRunning is cleared
+ *
+ * @param keepRunning cleared (i.e. by a signal handler) to stop
+ *
+ * @return false if the loop failed
+ *
+ * @pre Listen() succeeded
+ */
+bool AnalysisDaemon::Serve(const std::atomic<bool>& keepRunning) {
+	epoll_event events[64];
+	while (keepRunning) {
+		//Wake up now and then to notice keepRunning being cleared
+		int numReady = epoll_wait(epollFd, events, 64, POLL_MILLISECONDS);
+		if (numReady < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+
+		for (int i = 0; i < numReady; i++) {
+			int fd = events[i].data.fd;
+			if (fd == listenFd) {
+				AcceptClients();
+				continue;
+			}
+			auto found = connections.find(fd);
+			if (found == connections.end()) {
+				continue;
+			}
+			//A worker still answering keeps the socket open until it is done
+			if (!ReadClient(found->second)) {
+				epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+				connections.erase(found);
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Sends one request to a daemon and waits for the response
+ *
+ * @param socketPath path of the daemon's socket
+ * @param request the request line, without '\n'
+ * @param response updated with the response, ending with an empty line
+ *
+ * @return false if the daemon could not be reached
+ */
+bool AnalysisDaemon::Request(const std::string& socketPath, const std::string& request, std::string& response) {
+	sockaddr_un address;
+	if (!socketAddress(socketPath, address)) {
+		return false;
+	}
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return false;
+	}
+	if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || !SendAll(fd, request + "\n")) {
+		close(fd);
+		return false;
+	}
+
+	//Every response ends with an empty line
+	response.clear();
+	char buffer[4096];
+	while (!(response == "\n" || response.ends_with("\n\n"))) {
+		ssize_t numRead = read(fd, buffer, sizeof(buffer));
+		if (numRead < 0 && errno == EINTR) {
+			continue;
+		}
+		if (numRead <= 0) {
+			break;
+		}
+		response.append(buffer, numRead);
+	}
+	close(fd);
+	return response.ends_with("\n\n");
+}
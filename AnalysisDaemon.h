@@ -0,0 +1,264 @@
+/**
+ * The Analysis Daemon keeps parsed logs and their fitted models in memory
+ * and answers requests about them over a Unix domain socket, so a
+ * monitoring agent does not pay for a process start, a parse and a fit on
+ * every query.
+ *
+ * A request is one line; a response is one or more lines followed by an
+ * empty line. The first line of a response starts with OK or ERROR.
+ *
+ *   fit LOG              load LOG (once) and reply with the least-squares
+ *                        line of every core, in the report format
+ *   eval LOG CORE TIME   reply "OK <interpolation> <least-squares>", the two
+ *                        models of the core evaluated at TIME
+ *   refresh [LOG]        reload LOG, or every resident log, if it changed
+ *                        on disk since it was loaded
+ *   stats                reply with counters of the daemon as key=value pairs
+ *
+ * One thread runs an epoll loop that accepts connections and reads
+ * requests; the requests of a connection are answered in order by a worker
+ * of a thread pool. Resident logs are immutable once loaded and are found
+ * through a snapshot of the registry. Loading a log copies the snapshot,
+ * adds the log and publishes the copy with a new generation number, so
+ * only loads wait for each other. Every worker keeps the last snapshot it
+ * saw: while the generation is unchanged a query reads one atomic counter
+ * and touches no shared reference count or lock. Only the first query on
+ * a worker after a publish takes the lock, to pick up the new snapshot. A
+ * worker keeps an old snapshot, and the logs only it holds, alive until
+ * its next query.
+ */
+#ifndef ANALYSIS_DAEMON_H_INCLUDED
+#define ANALYSIS_DAEMON_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "InterpolantEvaluator.h"
+#include "ThreadPool.h"
+
+using SlopeAndIntercept = std::pair<double, double>;
+
+class AnalysisDaemon
+{
+private:
+
+	static constexpr std::size_t MAX_REQUEST_BYTES = 1 << 16; //!< Longest request line accepted
+	static constexpr int POLL_MILLISECONDS = 500; //!< How often the loop wakes up to notice it should stop
+
+	/**
+	 * A log and its models, never changed once loaded
+	 */
+	struct ResidentLog
+	{
+		std::string fileName = {}; //!< Path the log was loaded from
+		std::filesystem::file_time_type modified = {}; //!< Modification time of the log when loaded
+		std::uintmax_t size = 0; //!< Size of the log when loaded
+		int numCores = 0; //!< Number of cores
+		std::vector<int> times = {}; //!< Time of every reading
+		std::vector<InterpolantEvaluator> interpolants = {}; //!< Interpolations of every core, ready to evaluate
+		std::vector<SlopeAndIntercept> coreFits = {}; //!< Least squares line of every core
+	};
+
+	using Registry = std::unordered_map<std::string, std::shared_ptr<const ResidentLog>>;
+
+	/**
+	 * A client, shared by the loop and the worker answering it
+	 */
+	struct Connection
+	{
+		int fd = -1; //!< The client's socket, closed with the last reference
+		std::mutex lock; //!< Guards input and busy
+		std::string input = {}; //!< Received text not yet answered
+		bool busy = false; //!< Whether a worker is answering this connection
+
+		~Connection();
+	};
+
+	std::string socketPath; //!< Where the daemon listens
+	int listenFd = -1; //!< Listening socket
+	int epollFd = -1; //!< Epoll instance of the loop
+	std::unordered_map<int, std::shared_ptr<Connection>> connections = {}; //!< Open clients by socket, only used by the loop
+
+	uint64_t instanceId; //!< Tells the snapshots of this daemon apart from those of any other in a worker's cache
+	std::shared_ptr<const Registry> registry; //!< Latest snapshot of the resident logs, only used under loadLock
+	std::atomic<uint64_t> generation = 0; //!< Number of snapshots published so far
+	mutable std::mutex loadLock; //!< Serialises publishing snapshots; queries take it once after each publish
+
+	std::chrono::steady_clock::time_point start; //!< When the daemon started
+	std::atomic<uint64_t> requests = 0; //!< Requests answered
+	std::atomic<uint64_t> loads = 0; //!< Logs loaded from disk
+	std::atomic<uint64_t> evaluations = 0; //!< eval requests answered
+
+	ThreadPool workers; //!< Answers the requests (declared last so it stops first)
+
+	/**
+	 * Parses a log and fits its models
+	 *
+	 * @param fileName path of the log (text or binary)
+	 * @param unparsable updated with whether the log was read but holds a token that is not a number
+	 *
+	 * @return the log, nullptr if it could not be read or parsed, or has fewer than two readings
+	 */
+	static std::shared_ptr<const ResidentLog> LoadLog(const std::string& fileName, bool& unparsable);
+
+	/**
+	 * Fetches the latest snapshot of the resident logs through this
+	 * thread's cache, taking the lock only if a snapshot was published since
+	 * the last call
+	 *
+	 * @return the snapshot, valid until this thread calls Snapshot again
+	 */
+	const Registry& Snapshot() const;
+
+	/**
+	 * Looks up a resident log in this thread's snapshot
+	 *
+	 * @param fileName path the log was loaded from
+	 *
+	 * @return the log, nullptr if it is not resident; valid until this thread calls Snapshot again
+	 */
+	const ResidentLog* FindLog(const std::string& fileName) const;
+
+	/**
+	 * Publishes a new snapshot holding log in place of any older version
+	 *
+	 * @param log the log to make resident
+	 */
+	void StoreLog(std::shared_ptr<const ResidentLog> log);
+
+	/**
+	 * Answers one request line
+	 *
+	 * @param request the request, without its '\n'
+	 *
+	 * @return the response, ending with an empty line
+	 */
+	std::string HandleRequest(std::string_view request);
+
+	/**
+	 * Answers "fit LOG": loads the log unless it is resident already
+	 *
+	 * @param words words of the request
+	 *
+	 * @return the least-squares line of every core, after a line counting the
+	 *         cores and readings
+	 */
+	std::string Fit(const std::vector<std::string>& words);
+
+	/**
+	 * Answers "eval LOG CORE TIME": both models of a core at one time
+	 *
+	 * @param words words of the request
+	 *
+	 * @return the interpolation and the least-squares line evaluated at TIME
+	 */
+	std::string Evaluate(const std::vector<std::string>& words);
+
+	/**
+	 * Answers "refresh [LOG]": reloads a log, or every resident log, that
+	 * changed on disk since it was loaded
+	 *
+	 * @param words words of the request
+	 *
+	 * @return how many logs were reloaded
+	 */
+	std::string Refresh(const std::vector<std::string>& words);
+
+	/**
+	 * Answers "stats"
+	 *
+	 * @return counters of the daemon as key=value pairs
+	 */
+	std::string Stats() const;
+
+	/**
+	 * Accepts every waiting client and adds it to the loop
+	 */
+	void AcceptClients();
+
+	/**
+	 * Reads what a client sent and hands complete requests to a worker
+	 *
+	 * @param connection the client
+	 *
+	 * @return false once the client has hung up or misbehaved
+	 */
+	bool ReadClient(const std::shared_ptr<Connection>& connection);
+
+	/**
+	 * Worker task: answers the complete requests of a client in order until
+	 * none are left
+	 *
+	 * @param connection the client
+	 */
+	void AnswerClient(std::shared_ptr<Connection> connection);
+
+	/**
+	 * Writes all of text to a socket, waiting while its buffer is full
+	 *
+	 * @param fd the socket
+	 * @param text what to send
+	 *
+	 * @return false if the peer went away
+	 */
+	static bool SendAll(int fd, std::string_view text);
+
+public:
+
+	/**
+	 * Sets up a daemon that is not listening yet
+	 *
+	 * @param socketPath path of the Unix domain socket to serve on
+	 * @param numThreads workers answering requests
+	 */
+	AnalysisDaemon(const std::string& socketPath, int numThreads);
+
+	/**
+	 * Closes every client and removes the socket
+	 */
+	~AnalysisDaemon();
+
+	AnalysisDaemon(const AnalysisDaemon&) = delete;
+	AnalysisDaemon& operator=(const AnalysisDaemon&) = delete;
+
+	/**
+	 * Creates the socket. A socket left behind by a daemon that is no longer
+	 * running is replaced.
+	 *
+	 * @return false if the socket could not be created, or another daemon
+	 *         is serving on it
+	 */
+	bool Listen();
+
+	/**
+	 * Answers requests until keepRunning is cleared
+	 *
+	 * @param keepRunning cleared (i.e. by a signal handler) to stop
+	 *
+	 * @return false if the loop failed
+	 *
+	 * @pre Listen() succeeded
+	 */
+	bool Serve(const std::atomic<bool>& keepRunning);
+
+	/**
+	 * Sends one request to a daemon and waits for the response
+	 *
+	 * @param socketPath path of the daemon's socket
+	 * @param request the request line, without '\n'
+	 * @param response updated with the response, ending with an empty line
+	 *
+	 * @return false if the daemon could not be reached
+	 */
+	static bool Request(const std::string& socketPath, const std::string& request, std::string& response);
+};
+#endif
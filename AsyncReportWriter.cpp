@@ -0,0 +1,384 @@
+#include "AsyncReportWriter.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Sets up an io_uring instance with room for every buffer
+ *
+ * @return false if the kernel does not allow io_uring or cannot write through it
+ */
+bool AsyncReportWriter::SetupIoUring() {
+	//One entry per buffer plus the NOP that stops the reaper, so the rings never fill up
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	int fd = syscall(__NR_io_uring_setup, static_cast<unsigned>(maxBuffers + 1), &params);
+	if (fd < 0) {
+		return false;
+	}
+	ring.fd = fd;
+	if (!ProbeWrite()) {
+		CloseIoUring();
+		return false;
+	}
+
+	ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMap) {
+		ring.sqRingSize = ring.cqRingSize = ring.sqRingSize > ring.cqRingSize ? ring.sqRingSize : ring.cqRingSize;
+	}
+
+	void* sqRing = mmap(nullptr, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (sqRing == MAP_FAILED) {
+		CloseIoUring();
+		return false;
+	}
+	ring.sqRing = sqRing;
+	void* cqRing = singleMap ? sqRing
+		: mmap(nullptr, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	if (cqRing == MAP_FAILED) {
+		CloseIoUring();
+		return false;
+	}
+	ring.cqRing = cqRing;
+	ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes = mmap(nullptr, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED) {
+		CloseIoUring();
+		return false;
+	}
+	ring.sqes = sqes;
+
+	char* sqBase = static_cast<char*>(sqRing);
+	char* cqBase = static_cast<char*>(cqRing);
+	ring.sqTail = reinterpret_cast<unsigned*>(sqBase + params.sq_off.tail);
+	ring.sqMask = reinterpret_cast<unsigned*>(sqBase + params.sq_off.ring_mask);
+	ring.sqArray = reinterpret_cast<unsigned*>(sqBase + params.sq_off.array);
+	ring.cqHead = reinterpret_cast<unsigned*>(cqBase + params.cq_off.head);
+	ring.cqTail = reinterpret_cast<unsigned*>(cqBase + params.cq_off.tail);
+	ring.cqMask = reinterpret_cast<unsigned*>(cqBase + params.cq_off.ring_mask);
+	ring.cqes = cqBase + params.cq_off.cqes;
+	return true;
+}
+
+/**
+ * Asks the kernel which requests the io_uring instance supports. Older
+ * kernels have io_uring but fail every IORING_OP_WRITE with -EINVAL.
+ *
+ * @return true if IORING_OP_WRITE is supported
+ */
+bool AsyncReportWriter::ProbeWrite() const {
+	//Room for every opcode the probe can report; kernels without the probe predate IORING_OP_WRITE too
+	alignas(io_uring_probe) unsigned char storage[sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op)] = {};
+	io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage);
+	if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+		return false;
+	}
+	return IORING_OP_WRITE <= probe->last_op && IORING_OP_WRITE < probe->ops_len
+		&& (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) != 0;
+}
+
+/**
+ * Unmaps the rings and closes the io_uring instance
+ */
+void AsyncReportWriter::CloseIoUring() {
+	if (ring.sqes != nullptr) {
+		munmap(ring.sqes, ring.sqesSize);
+	}
+	if (ring.cqRing != nullptr && ring.cqRing != ring.sqRing) {
+		munmap(ring.cqRing, ring.cqRingSize);
+	}
+	if (ring.sqRing != nullptr) {
+		munmap(ring.sqRing, ring.sqRingSize);
+	}
+	if (ring.fd >= 0) {
+		close(ring.fd);
+	}
+	ring = {};
+}
+
+/**
+ * Queues a buffer for writing
+ *
+ * @param buffer the buffer, holding the rest of its text to write
+ * @param guard the held lock
+ */
+void AsyncReportWriter::Submit(Buffer* buffer, std::unique_lock<std::mutex>& guard) {
+	if (UsesIoUring()) {
+		if (!SubmitToRing(IORING_OP_WRITE, buffer)) {
+			//Nothing will complete it, so give up on this write
+			CompleteWrite(buffer, -EIO, guard);
+		}
+	}
+	else {
+		queuedWrites.push_back(buffer);
+		writeQueued.notify_one();
+	}
+}
+
+/**
+ * Queues a request on the submission ring and tells the kernel about it
+ *
+ * @param opcode IORING_OP_WRITE or IORING_OP_NOP
+ * @param buffer buffer to write (nullptr for a NOP)
+ *
+ * @return false if the kernel refused the request
+ *
+ * @pre lock is held
+ */
+bool AsyncReportWriter::SubmitToRing(uint8_t opcode, Buffer* buffer) {
+	std::atomic_ref<unsigned> sqTail(*ring.sqTail);
+	unsigned tail = sqTail.load(std::memory_order_relaxed);
+	unsigned index = tail & *ring.sqMask;
+
+	io_uring_sqe* sqe = static_cast<io_uring_sqe*>(ring.sqes) + index;
+	std::memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = opcode;
+	sqe->fd = -1;
+	if (buffer != nullptr) {
+		sqe->fd = buffer->fd;
+		sqe->addr = reinterpret_cast<uint64_t>(buffer->data.get() + buffer->written);
+		sqe->len = static_cast<uint32_t>(buffer->size - buffer->written);
+		sqe->off = buffer->offset + buffer->written;
+	}
+	sqe->user_data = reinterpret_cast<uint64_t>(buffer);
+	ring.sqArray[index] = index;
+	sqTail.store(tail + 1, std::memory_order_release);
+
+	long submitted;
+	do {
+		submitted = syscall(__NR_io_uring_enter, ring.fd, 1, 0, 0, nullptr, 0);
+	} while (submitted < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+	return submitted == 1;
+}
+
+/**
+ * Handles the end of one write: returns the buffer, or queues the rest of
+ * it again after a short write
+ *
+ * @param buffer buffer that was written
+ * @param result bytes written, or a negative errno
+ * @param guard the held lock
+ */
+void AsyncReportWriter::CompleteWrite(Buffer* buffer, long result, std::unique_lock<std::mutex>& guard) {
+	if (result == -EINTR || result == -EAGAIN) {
+		Submit(buffer, guard);
+		return;
+	}
+	if (result <= 0) {
+		failed = true;
+	}
+	else {
+		buffer->written += result;
+		bytesWritten += result;
+		if (buffer->written < buffer->size) {
+			Submit(buffer, guard);
+			return;
+		}
+	}
+	freeBuffers.push_back(buffer);
+	bufferFree.notify_all();
+}
+
+/**
+ * Loop of completionThread with io_uring: reaps completed writes until
+ * the NOP queued by Stop
+ */
+void AsyncReportWriter::ReapLoop() {
+	std::atomic_ref<unsigned> cqHead(*ring.cqHead);
+	std::atomic_ref<unsigned> cqTail(*ring.cqTail);
+	bool stopSeen = false;
+	while (!stopSeen) {
+		long waited = syscall(__NR_io_uring_enter, ring.fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+		if (waited < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			//The ring is unusable, so every queued write is lost
+			std::unique_lock<std::mutex> guard(lock);
+			failed = true;
+			freeBuffers.clear();
+			for (const std::unique_ptr<Buffer>& buffer : buffers) {
+				freeBuffers.push_back(buffer.get());
+			}
+			bufferFree.notify_all();
+			return;
+		}
+
+		unsigned head = cqHead.load(std::memory_order_relaxed);
+		unsigned tail = cqTail.load(std::memory_order_acquire);
+		std::unique_lock<std::mutex> guard(lock);
+		for (; head != tail; head++) {
+			const io_uring_cqe* cqe = static_cast<const io_uring_cqe*>(ring.cqes) + (head & *ring.cqMask);
+			Buffer* buffer = reinterpret_cast<Buffer*>(cqe->user_data);
+			if (buffer == nullptr) {
+				stopSeen = true;
+			}
+			else {
+				CompleteWrite(buffer, cqe->res, guard);
+			}
+		}
+		cqHead.store(head, std::memory_order_release);
+	}
+}
+
+/**
+ * Loop of completionThread without io_uring: pwrites queued buffers until
+ * Stop
+ */
+void AsyncReportWriter::WriteLoop() {
+	std::unique_lock<std::mutex> guard(lock);
+	while (true) {
+		writeQueued.wait(guard, [this] { return stopping || !queuedWrites.empty(); });
+		if (queuedWrites.empty()) {
+			return;
+		}
+		Buffer* buffer = queuedWrites.front();
+		queuedWrites.pop_front();
+
+		guard.unlock();
+		long result = pwrite(buffer->fd, buffer->data.get() + buffer->written, buffer->size - buffer->written,
+			buffer->offset + buffer->written);
+		if (result < 0) {
+			result = -errno;
+		}
+		guard.lock();
+		CompleteWrite(buffer, result, guard);
+	}
+}
+
+/**
+ * Waits for every write, then ends completionThread
+ *
+ * @return false if the reaper could not be woken and was left running
+ */
+bool AsyncReportWriter::Stop() {
+	Finish();
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		stopping = true;
+		if (UsesIoUring() && !SubmitToRing(IORING_OP_NOP, nullptr)) {
+			//The reaper cannot be woken, so leave it to end with the program
+			completionThread.detach();
+			return false;
+		}
+		writeQueued.notify_one();
+	}
+	completionThread.join();
+	return true;
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Starts the background thread
+ *
+ * @param maxBuffers buffers that may be queued at once (at least 1)
+ * @param bufferBytes size of every buffer (at least 1)
+ * @param useIoUring false to use the thread fallback even where io_uring works
+ */
+AsyncReportWriter::AsyncReportWriter(std::size_t maxBuffers, std::size_t bufferBytes, bool useIoUring)
+	: maxBuffers(maxBuffers > 0 ? maxBuffers : 1), bufferBytes(bufferBytes > 0 ? bufferBytes : 1) {
+	if (useIoUring && SetupIoUring()) {
+		completionThread = std::thread(&AsyncReportWriter::ReapLoop, this);
+	}
+	else {
+		completionThread = std::thread(&AsyncReportWriter::WriteLoop, this);
+	}
+}
+
+/**
+ * Finishes every write and stops the background thread
+ */
+AsyncReportWriter::~AsyncReportWriter() {
+	//A reaper left running still uses the rings, so they stay mapped
+	if (Stop()) {
+		CloseIoUring();
+	}
+}
+
+/**
+ * Creates (or truncates) a file to write a report to
+ *
+ * @param fileName path of the file
+ *
+ * @return the stream to pass to Append
+ */
+int AsyncReportWriter::Open(const std::string& fileName) {
+	int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	std::unique_lock<std::mutex> guard(lock);
+	if (fd < 0) {
+		failed = true;
+	}
+	fds.push_back(fd);
+	offsets.push_back(0);
+	return fds.size() - 1;
+}
+
+/**
+ * Queues text to be written after everything appended to the stream
+ * before. Waits while every buffer is queued. Several threads may append
+ * at once, as long as each stream is only appended to by one.
+ *
+ * @param stream stream returned by Open
+ * @param text text to write, copied before this returns
+ *
+ * @pre Finish has not been called since stream was opened
+ */
+void AsyncReportWriter::Append(int stream, std::string_view text) {
+	std::unique_lock<std::mutex> guard(lock);
+	int fd = fds[stream];
+	if (fd < 0) {
+		return;
+	}
+	while (!text.empty()) {
+		//Buffers are only created once every existing one is queued
+		if (freeBuffers.empty() && buffers.size() < maxBuffers) {
+			buffers.push_back(std::make_unique<Buffer>());
+			buffers.back()->data = std::make_unique<char[]>(bufferBytes);
+			freeBuffers.push_back(buffers.back().get());
+		}
+		bufferFree.wait(guard, [this] { return !freeBuffers.empty(); });
+		Buffer* buffer = freeBuffers.back();
+		freeBuffers.pop_back();
+
+		//The offset is claimed before copying, so the lock can be dropped for the copy
+		std::size_t size = text.size() < bufferBytes ? text.size() : bufferBytes;
+		buffer->fd = fd;
+		buffer->offset = offsets[stream];
+		buffer->size = size;
+		buffer->written = 0;
+		offsets[stream] += size;
+
+		guard.unlock();
+		std::memcpy(buffer->data.get(), text.data(), size);
+		text.remove_prefix(size);
+		guard.lock();
+		Submit(buffer, guard);
+	}
+}
+
+/**
+ * Waits for every write and closes every stream
+ *
+ * @return false if a file could not be opened or written
+ */
+bool AsyncReportWriter::Finish() {
+	std::unique_lock<std::mutex> guard(lock);
+	bufferFree.wait(guard, [this] { return freeBuffers.size() == buffers.size(); });
+	for (int fd : fds) {
+		if (fd >= 0 && close(fd) != 0) {
+			failed = true;
+		}
+	}
+	fds.clear();
+	offsets.clear();
+	return !failed;
+}
@@ -0,0 +1,209 @@
+/**
+ * The Async Report Writer writes reports in the background while the next
+ * part of them is still being formatted, so a run takes about as long as
+ * the slower of compute and disk rather than both added together.
+ *
+ * Text handed to Append is copied into one of a fixed number of buffers and
+ * queued for writing at its place in the file. When every buffer is queued,
+ * Append waits for one to be written, which keeps memory use bounded however
+ * far the formatting gets ahead of the disk.
+ *
+ * Writes go through io_uring (set up with raw system calls) when the kernel
+ * allows it and its probe lists IORING_OP_WRITE (5.6 and later), otherwise a
+ * writer thread issues them with pwrite. Either way one background thread
+ * handles the completed writes.
+ */
+#ifndef ASYNC_REPORT_WRITER_H_INCLUDED
+#define ASYNC_REPORT_WRITER_H_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+class AsyncReportWriter
+{
+private:
+
+	/**
+	 * One piece of a report on its way to the disk
+	 */
+	struct Buffer
+	{
+		std::unique_ptr<char[]> data; //!< Text to write
+		std::size_t size = 0; //!< Bytes of data still to write
+		std::size_t written = 0; //!< Bytes of data already written
+		int fd = -1; //!< File the text goes to
+		uint64_t offset = 0; //!< Where data starts within the file
+	};
+
+	/**
+	 * Submission and completion rings shared with the kernel
+	 */
+	struct IoUring
+	{
+		int fd = -1; //!< The io_uring instance (-1 when the thread fallback is used)
+		void* sqRing = nullptr; //!< Mapped submission ring
+		void* cqRing = nullptr; //!< Mapped completion ring (the same mapping as sqRing on newer kernels)
+		void* sqes = nullptr; //!< Mapped submission entries
+		std::size_t sqRingSize = 0; //!< Bytes of the sqRing mapping
+		std::size_t cqRingSize = 0; //!< Bytes of the cqRing mapping
+		std::size_t sqesSize = 0; //!< Bytes of the sqes mapping
+		unsigned* sqTail = nullptr; //!< Next submission slot to fill
+		unsigned* sqMask = nullptr; //!< Mask turning a position into a submission slot
+		unsigned* sqArray = nullptr; //!< Indices of the entries to submit
+		unsigned* cqHead = nullptr; //!< Next completion to read
+		unsigned* cqTail = nullptr; //!< One past the last completion posted
+		unsigned* cqMask = nullptr; //!< Mask turning a position into a completion slot
+		void* cqes = nullptr; //!< Completion entries
+	};
+
+	std::size_t maxBuffers; //!< Buffers that may exist at once
+	std::size_t bufferBytes; //!< Size of every buffer
+
+	std::mutex lock; //!< Guards everything below but the rings' completion side
+	std::condition_variable bufferFree; //!< Signalled when a buffer is returned to freeBuffers
+	std::condition_variable writeQueued; //!< Signalled when the fallback thread has a write or should stop
+
+	std::vector<std::unique_ptr<Buffer>> buffers = {}; //!< Every buffer, created as they are first needed
+	std::vector<Buffer*> freeBuffers = {}; //!< Buffers not being written
+	std::deque<Buffer*> queuedWrites = {}; //!< Writes waiting for the fallback thread
+	std::vector<int> fds = {}; //!< File of every stream
+	std::vector<uint64_t> offsets = {}; //!< Bytes appended to every stream so far
+
+	IoUring ring = {}; //!< io_uring state, unused by the thread fallback
+	std::thread completionThread; //!< Writes (fallback) or reaps completed writes (io_uring)
+	uint64_t bytesWritten = 0; //!< Bytes written so far
+	bool failed = false; //!< Set when a file could not be opened or written
+	bool stopping = false; //!< Set to end completionThread
+
+	/**
+	 * Sets up an io_uring instance with room for every buffer
+	 *
+	 * @return false if the kernel does not allow io_uring or cannot write through it
+	 */
+	bool SetupIoUring();
+
+	/**
+	 * Asks the kernel which requests the io_uring instance supports. Older
+	 * kernels have io_uring but fail every IORING_OP_WRITE with -EINVAL.
+	 *
+	 * @return true if IORING_OP_WRITE is supported
+	 */
+	bool ProbeWrite() const;
+
+	/**
+	 * Unmaps the rings and closes the io_uring instance
+	 */
+	void CloseIoUring();
+
+	/**
+	 * Queues a buffer for writing
+	 *
+	 * @param buffer the buffer, holding the rest of its text to write
+	 * @param guard the held lock
+	 */
+	void Submit(Buffer* buffer, std::unique_lock<std::mutex>& guard);
+
+	/**
+	 * Queues a request on the submission ring and tells the kernel about it
+	 *
+	 * @param opcode IORING_OP_WRITE or IORING_OP_NOP
+	 * @param buffer buffer to write (nullptr for a NOP)
+	 *
+	 * @return false if the kernel refused the request
+	 *
+	 * @pre lock is held
+	 */
+	bool SubmitToRing(uint8_t opcode, Buffer* buffer);
+
+	/**
+	 * Handles the end of one write: returns the buffer, or queues the rest of
+	 * it again after a short write
+	 *
+	 * @param buffer buffer that was written
+	 * @param result bytes written, or a negative errno
+	 * @param guard the held lock
+	 */
+	void CompleteWrite(Buffer* buffer, long result, std::unique_lock<std::mutex>& guard);
+
+	/**
+	 * Loop of completionThread with io_uring: reaps completed writes until
+	 * the NOP queued by Stop
+	 */
+	void ReapLoop();
+
+	/**
+	 * Loop of completionThread without io_uring: pwrites queued buffers until
+	 * Stop
+	 */
+	void WriteLoop();
+
+	/**
+	 * Waits for every write, then ends completionThread
+	 *
+	 * @return false if the reaper could not be woken and was left running
+	 */
+	bool Stop();
+
+public:
+
+	static constexpr std::size_t DEFAULT_BUFFERS = 8; //!< Buffers used unless told otherwise
+	static constexpr std::size_t DEFAULT_BUFFER_BYTES = 1 << 20; //!< Buffer size used unless told otherwise
+
+	/**
+	 * Starts the background thread
+	 *
+	 * @param maxBuffers buffers that may be queued at once (at least 1)
+	 * @param bufferBytes size of every buffer (at least 1)
+	 * @param useIoUring false to use the thread fallback even where io_uring works
+	 */
+	AsyncReportWriter(std::size_t maxBuffers = DEFAULT_BUFFERS, std::size_t bufferBytes = DEFAULT_BUFFER_BYTES,
+		bool useIoUring = true);
+
+	/**
+	 * Finishes every write and stops the background thread
+	 */
+	~AsyncReportWriter();
+
+	AsyncReportWriter(const AsyncReportWriter&) = delete;
+	AsyncReportWriter& operator=(const AsyncReportWriter&) = delete;
+
+	/**
+	 * Creates (or truncates) a file to write a report to
+	 *
+	 * @param fileName path of the file
+	 *
+	 * @return the stream to pass to Append
+	 */
+	int Open(const std::string& fileName);
+
+	/**
+	 * Queues text to be written after everything appended to the stream
+	 * before. Waits while every buffer is queued. Several threads may append
+	 * at once, as long as each stream is only appended to by one.
+	 *
+	 * @param stream stream returned by Open
+	 * @param text text to write, copied before this returns
+	 *
+	 * @pre Finish has not been called since stream was opened
+	 */
+	void Append(int stream, std::string_view text);
+
+	/**
+	 * Waits for every write and closes every stream
+	 *
+	 * @return false if a file could not be opened or written
+	 */
+	bool Finish();
+
+	bool UsesIoUring() const { return ring.fd >= 0; }
+	uint64_t GetBytesWritten() const { return bytesWritten; }
+};
+#endif
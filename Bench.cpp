@@ -0,0 +1,435 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <filesystem>
+#include <memory>
+#include <algorithm>
+#include <unistd.h>
+
+#include "parseTemps.h"
+#include "MappedTempParser.h"
+#include "DataPreProcessor.h"
+#include "PiecewiseLinearInterpolation.h"
+#include "LeastSquaresApproximation.h"
+#include "UniformStepEngine.h"
+#include "InterpolantEvaluator.h"
+#include "CoreCorrelation.h"
+#include "BinaryLog.h"
+#include "MappedFile.h"
+#include "ReportWriter.h"
+#include "AsyncReportWriter.h"
+#include "PipelineArena.h"
+
+using namespace std;
+
+// Benchmark driver for the cpuTemps pipeline. Generates a synthetic log,
+// runs every stage of the pipeline on it several times and prints the mean,
+// standard deviation and throughput of each stage.
+
+// Settings taken from the command line
+struct BenchOptions {
+    size_t lines = 100000;
+    int cores = 4;
+    int reps = 5;
+    unsigned seed = 42;
+    string dir = "";
+    bool keep = false;
+};
+
+// Stages in pipeline order, as printed in the results table. The first three
+// are the older two-pass ingestion that the fused parse replaces.
+const vector<string> STAGES = {
+    "parse_raw_temps",
+    "MappedTempParser::ParseReadings",
+    "DataPreProcessor",
+    "DataPreProcessor (fused parse)",
+    "PiecewiseLinearInterpolation::Calculate",
+    "LeastSquaresApproximation (all cores)",
+    "PiecewiseLinearInterpolation::ToString",
+    "LeastSquaresApproximation::ToString",
+    "outputOrganizer",
+    "UniformStepEngine::Interpolate",
+    "UniformStepEngine::Fit",
+    "DataPreProcessor (binary log)",
+    "AsyncReportWriter",
+    "CoreCorrelation",
+    "InterpolantEvaluator (uniform, batched)",
+    "InterpolantEvaluator (Eytzinger, batched)",
+    "InterpolantEvaluator::EvaluateSorted",
+};
+const size_t FIRST_PIPELINE_STAGE = 3; // Stages from here on are what cpuTemps runs
+const size_t FIRST_FAST_PATH_STAGE = 9; // Opt-in fast paths, compared against the stages they replace and left out of the pipeline total
+
+// Writes a log of random-walk core temperatures in the same format as the
+// lm-sensors captures (+61.0°C per core, space separated). Returns the size
+// of the log in bytes.
+size_t generateLog(const string& fileName, const BenchOptions& options) {
+    mt19937 generator(options.seed);
+    normal_distribution<double> change(0.0, 1.5);
+    vector<double> temps(options.cores);
+    for (int core = 0; core < options.cores; core++) {
+        temps[core] = 45.0 + 5.0 * core;
+    }
+
+    ofstream out(fileName, ios::binary);
+    string line;
+    char reading[32];
+    for (size_t i = 0; i < options.lines; i++) {
+        line.clear();
+        for (int core = 0; core < options.cores; core++) {
+            temps[core] = min(100.0, max(25.0, temps[core] + change(generator)));
+            snprintf(reading, sizeof(reading), "%+.1f°C", temps[core]);
+            if (core > 0) {
+                line += ' ';
+            }
+            line += reading;
+        }
+        line += '\n';
+        out << line;
+    }
+    out.close();
+    return filesystem::file_size(fileName);
+}
+
+// Picks query times spread over the readings and a step past either end:
+// every fifth one is the time of a reading, the rest fall anywhere
+vector<double> makeQueryTimes(std::span<const int> times, size_t numQueries) {
+    mt19937 generator(7);
+    double step = times.size() > 1 ? times[1] - times[0] : 1.0;
+    uniform_real_distribution<double> anyTime(times.front() - step, times.back() + step);
+    uniform_int_distribution<size_t> anyReading(0, times.size() - 1);
+    vector<double> queryTimes(numQueries);
+    for (size_t i = 0; i < numQueries; i++) {
+        queryTimes[i] = i % 5 == 0 ? times[anyReading(generator)] : anyTime(generator);
+    }
+    return queryTimes;
+}
+
+// Checks the evaluated temperatures of every core against a plain binary
+// search for the covering interpolation, printing the first disagreement
+void checkEvaluations(const string& stageName, std::span<const int> times, const vector<vector<SlopeAndIntercept>>& coreLineParts,
+                      const vector<double>& queryTimes, const vector<double>& temps) {
+    for (size_t core = 0; core < coreLineParts.size(); core++) {
+        for (size_t i = 0; i < queryTimes.size(); i++) {
+            size_t segment = upper_bound(times.begin(), times.end(), queryTimes[i]) - times.begin();
+            segment = min(segment == 0 ? 0 : segment - 1, coreLineParts[core].size() - 1);
+            const SlopeAndIntercept& part = coreLineParts[core][segment];
+            if (temps[core * queryTimes.size() + i] != part.second + part.first * queryTimes[i]) {
+                cerr << "ERROR: " << stageName << " disagrees with a binary search for core " << core
+                     << " at time " << queryTimes[i] << "\n";
+                return;
+            }
+        }
+    }
+}
+
+// Builds an evaluator per core from slope and intercept pairs
+vector<InterpolantEvaluator> makeEvaluators(std::span<const int> times, const vector<vector<SlopeAndIntercept>>& coreLineParts) {
+    vector<InterpolantEvaluator> evaluators;
+    for (const vector<SlopeAndIntercept>& lineParts : coreLineParts) {
+        vector<double> slopes(lineParts.size());
+        vector<double> intercepts(lineParts.size());
+        for (size_t i = 0; i < lineParts.size(); i++) {
+            slopes[i] = lineParts[i].first;
+            intercepts[i] = lineParts[i].second;
+        }
+        evaluators.emplace_back(times, slopes, intercepts);
+    }
+    return evaluators;
+}
+
+// Runs fn once and returns how long it took in seconds
+template<typename Function>
+double timeStage(Function&& fn) {
+    auto start = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Runs the whole pipeline once over the log, adding the time of each stage
+// to stageTimes (indexed like STAGES). The parsed data is allocated from
+// arena, the same way cpuTemps does it. binaryLogName is the same log
+// converted by cpuTempsConvert.
+void runPipeline(const string& logName, const string& binaryLogName, vector<vector<double>>& stageTimes, PipelineArena& arena) {
+    int stage = 0;
+
+    stageTimes[stage++].push_back(timeStage([&] {
+        ifstream input_temps(logName);
+        auto readings = parse_raw_temps<std::vector<CoreTempReading>>(input_temps);
+        if (readings.empty()) {
+            cerr << "ERROR: " << logName << " parsed to nothing" << "\n";
+        }
+    }));
+
+    std::pmr::vector<ArenaCoreTempReading> readings(&arena);
+    stageTimes[stage++].push_back(timeStage([&] {
+        MappedTempParser input_temps(logName);
+        readings = input_temps.ParseReadings<std::pmr::vector<ArenaCoreTempReading>>(30, &arena);
+    }));
+
+    std::unique_ptr<DataPreProcessor> preProcessor;
+    stageTimes[stage++].push_back(timeStage([&] {
+        preProcessor = make_unique<DataPreProcessor>(readings, &arena);
+    }));
+    readings.clear();
+
+    stageTimes[stage++].push_back(timeStage([&] {
+        MappedTempParser input_temps(logName);
+        preProcessor = make_unique<DataPreProcessor>(input_temps.Contents(), 30, &arena);
+    }));
+    const DataPreProcessor& processedData = *preProcessor;
+
+    int numCores = processedData.GetNumCores();
+    std::span<const int> times = processedData.GetTimes();
+
+    PiecewiseLinearInterpolation interpolationCalculator;
+    InterpolationTable interpolations(&arena);
+    stageTimes[stage++].push_back(timeStage([&] {
+        interpolationCalculator.Calculate(interpolations, processedData);
+    }));
+
+    LeastSquaresApproximation leastSquareCalculator(&arena);
+    std::vector<SlopeAndIntercept> coreSquareApprox(numCores);
+    stageTimes[stage++].push_back(timeStage([&] {
+        leastSquareCalculator.Calculate(coreSquareApprox, processedData);
+    }));
+
+    //ToString takes the interpolations as pairs, so gather them outside the timed region
+    std::vector<std::vector<SlopeAndIntercept>> coreLineParts(numCores);
+    for (int core = 0; core < numCores; core++) {
+        interpolationCalculator.Calculate(coreLineParts[core], times, processedData.GetCoreReadings(core));
+    }
+
+    std::vector<string> coreReports(numCores);
+    stageTimes[stage++].push_back(timeStage([&] {
+        for (int core = 0; core < numCores; core++) {
+            coreReports[core] = interpolationCalculator.ToString(coreLineParts[core], times);
+        }
+    }));
+
+    std::vector<string> leastSquareLines(numCores);
+    stageTimes[stage++].push_back(timeStage([&] {
+        for (int core = 0; core < numCores; core++) {
+            leastSquareLines[core] = leastSquareCalculator.ToString(coreSquareApprox[core], times);
+        }
+    }));
+    for (int core = 0; core < numCores; core++) {
+        coreReports[core] += leastSquareLines[core];
+    }
+
+    stageTimes[stage++].push_back(timeStage([&] {
+        outputOrganizer(coreReports, logName);
+    }));
+
+    //The generated log is uniform, so this only misses for more than MAX_UNIFORM_CORES cores
+    const UniformStepFunctions* uniformEngine = FindUniformStepEngine(processedData);
+    stageTimes[stage++].push_back(timeStage([&] {
+        if (uniformEngine != nullptr) {
+            uniformEngine->Interpolate(interpolations, processedData);
+        }
+    }));
+    stageTimes[stage++].push_back(timeStage([&] {
+        if (uniformEngine != nullptr) {
+            uniformEngine->Fit(coreSquareApprox, processedData);
+        }
+    }));
+
+    std::unique_ptr<DataPreProcessor> binaryData;
+    stageTimes[stage++].push_back(timeStage([&] {
+        MappedFile binaryFile(binaryLogName);
+        BinaryLog binaryLog(binaryFile.Contents());
+        if (binaryLog.IsValid()) {
+            binaryData = make_unique<DataPreProcessor>(binaryLog, &arena);
+        }
+    }));
+
+    //The same reports as outputOrganizer, handed over whole rather than streamed while formatting
+    stageTimes[stage++].push_back(timeStage([&] {
+        AsyncReportWriter reportWriter;
+        for (int core = 0; core < numCores; core++) {
+            reportWriter.Append(reportWriter.Open(coreReportName(logName, core)), coreReports[core]);
+        }
+        reportWriter.Finish();
+    }));
+
+    CoreCorrelation correlation;
+    stageTimes[stage++].push_back(timeStage([&] {
+        correlation.Calculate(processedData);
+    }));
+
+    //One query per reading and core. The evenly spaced log takes the O(1)
+    //lookup; dropping every seventh reading makes the times irregular, which
+    //takes the Eytzinger search.
+    vector<double> queryTimes = makeQueryTimes(times, times.size());
+    vector<double> sortedTimes = queryTimes;
+    sort(sortedTimes.begin(), sortedTimes.end());
+    vector<int> irregularTimes;
+    vector<vector<SlopeAndIntercept>> irregularLineParts(numCores);
+    for (size_t i = 0; i < times.size(); i++) {
+        if (i % 7 != 6 || i + 1 == times.size()) {
+            irregularTimes.push_back(times[i]);
+        }
+    }
+    for (int core = 0; core < numCores; core++) {
+        std::span<const double> temps = processedData.GetCoreReadings(core);
+        vector<double> irregularTemps;
+        for (size_t i = 0; i < times.size(); i++) {
+            if (i % 7 != 6 || i + 1 == times.size()) {
+                irregularTemps.push_back(temps[i]);
+            }
+        }
+        interpolationCalculator.Calculate(irregularLineParts[core], irregularTimes, irregularTemps);
+    }
+    vector<InterpolantEvaluator> evaluators = makeEvaluators(times, coreLineParts);
+    vector<InterpolantEvaluator> irregularEvaluators = makeEvaluators(irregularTimes, irregularLineParts);
+
+    vector<double> evaluated(queryTimes.size() * numCores);
+    std::span<double> coreEvaluated(evaluated);
+    stageTimes[stage].push_back(timeStage([&] {
+        for (int core = 0; core < numCores; core++) {
+            evaluators[core].Evaluate(queryTimes, coreEvaluated.subspan(core * queryTimes.size(), queryTimes.size()));
+        }
+    }));
+    checkEvaluations(STAGES[stage++], times, coreLineParts, queryTimes, evaluated);
+
+    stageTimes[stage].push_back(timeStage([&] {
+        for (int core = 0; core < numCores; core++) {
+            irregularEvaluators[core].Evaluate(queryTimes, coreEvaluated.subspan(core * queryTimes.size(), queryTimes.size()));
+        }
+    }));
+    checkEvaluations(STAGES[stage++], irregularTimes, irregularLineParts, queryTimes, evaluated);
+
+    stageTimes[stage].push_back(timeStage([&] {
+        for (int core = 0; core < numCores; core++) {
+            evaluators[core].EvaluateSorted(sortedTimes, coreEvaluated.subspan(core * sortedTimes.size(), sortedTimes.size()));
+        }
+    }));
+    checkEvaluations(STAGES[stage++], times, coreLineParts, sortedTimes, evaluated);
+}
+
+// Prints one row per stage with the mean, standard deviation and throughput
+void printResults(const vector<vector<double>>& stageTimes, size_t numSamples, size_t numBytes) {
+    cout << left << setw(42) << "stage" << right
+         << setw(12) << "mean ms" << setw(12) << "stddev ms" << setw(12) << "min ms"
+         << setw(16) << "samples/s" << setw(12) << "MB/s" << "\n";
+
+    double totalMean = 0.0;
+    for (size_t stage = 0; stage < STAGES.size(); stage++) {
+        const vector<double>& samples = stageTimes[stage];
+        double mean = 0.0;
+        double fastest = samples[0];
+        for (double seconds : samples) {
+            mean += seconds;
+            fastest = min(fastest, seconds);
+        }
+        mean /= samples.size();
+
+        //Sample standard deviation, 0 for a single repetition
+        double variance = 0.0;
+        for (double seconds : samples) {
+            variance += (seconds - mean) * (seconds - mean);
+        }
+        variance = samples.size() > 1 ? variance / (samples.size() - 1) : 0.0;
+
+        if (stage >= FIRST_PIPELINE_STAGE && stage < FIRST_FAST_PATH_STAGE) {
+            totalMean += mean;
+        }
+
+        double elapsed = mean > 0.0 ? mean : 1e-12;
+        cout << left << setw(42) << STAGES[stage] << right << fixed
+             << setprecision(3) << setw(12) << mean * 1e3 << setw(12) << sqrt(variance) * 1e3 << setw(12) << fastest * 1e3
+             << setprecision(0) << setw(16) << numSamples / elapsed
+             << setprecision(2) << setw(12) << numBytes / 1e6 / elapsed << "\n";
+    }
+
+    double elapsed = totalMean > 0.0 ? totalMean : 1e-12;
+    cout << left << setw(42) << "pipeline (fused parse onwards)" << right << fixed
+         << setprecision(3) << setw(12) << totalMean * 1e3 << setw(12) << "" << setw(12) << ""
+         << setprecision(0) << setw(16) << numSamples / elapsed
+         << setprecision(2) << setw(12) << numBytes / 1e6 / elapsed << "\n";
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--lines" && i + 1 < argc) {
+            options.lines = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--cores" && i + 1 < argc) {
+            options.cores = atoi(argv[++i]);
+        }
+        else if (arg == "--reps" && i + 1 < argc) {
+            options.reps = atoi(argv[++i]);
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--dir" && i + 1 < argc) {
+            options.dir = argv[++i];
+        }
+        else if (arg == "--keep") {
+            options.keep = true;
+        }
+        else {
+            cout << "Usage: " << argv[0] << " [--lines N] [--cores C] [--reps R] [--seed S] [--dir D] [--keep]" << "\n";
+            return 1;
+        }
+    }
+    if (options.lines < 2 || options.cores < 1 || options.reps < 1) {
+        cout << "ERROR: need at least 2 lines, 1 core and 1 repetition" << "\n";
+        return 1;
+    }
+
+    //The log and the reports go in a scratch directory that is removed afterwards
+    filesystem::path workDir = options.dir.empty()
+        ? filesystem::temp_directory_path() / ("cpuTempsBench-" + to_string(getpid()))
+        : filesystem::path(options.dir);
+    filesystem::create_directories(workDir);
+    string logName = (workDir / "benchTemps.txt").string();
+
+    size_t numBytes = generateLog(logName, options);
+
+    //The generated readings have one decimal, so they always fit the binary format
+    string binaryLogName = (workDir / "benchTemps.bin").string();
+    {
+        MappedTempParser input_temps(logName);
+        BinaryLog::Write(binaryLogName, DataPreProcessor(input_temps.Contents()));
+    }
+    size_t numSamples = options.lines * options.cores;
+    cout << "Log: " << options.lines << " lines x " << options.cores << " cores, "
+         << fixed << setprecision(2) << numBytes / 1e6 << " MB, " << options.reps << " repetitions" << "\n\n";
+
+    //One untimed run warms the page cache and the allocator
+    PipelineArena arena;
+    vector<vector<double>> stageTimes(STAGES.size());
+    runPipeline(logName, binaryLogName, stageTimes, arena);
+    arena.Reset();
+    stageTimes.assign(STAGES.size(), {});
+    for (int rep = 0; rep < options.reps; rep++) {
+        runPipeline(logName, binaryLogName, stageTimes, arena);
+        arena.Reset();
+    }
+    printResults(stageTimes, numSamples, numBytes);
+
+    if (!options.keep) {
+        std::error_code error;
+        if (options.dir.empty()) {
+            filesystem::remove_all(workDir, error);
+        }
+        else {
+            filesystem::remove(logName, error);
+            filesystem::remove(binaryLogName, error);
+            for (int core = 0; core < options.cores; core++) {
+                filesystem::remove(coreReportName(logName, core), error);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include "BinaryLog.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+#include "DataPreProcessor.h"
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Checks the header and that every block lies inside the log
+ *
+ * @return false if contents is not a binary log this code can read
+ */
+bool BinaryLog::Validate() const {
+	if (contents.size() < sizeof(BinaryLogHeader) || !HasMagic(contents)) {
+		return false;
+	}
+	const BinaryLogHeader* candidate = reinterpret_cast<const BinaryLogHeader*>(contents.data());
+	bool knownVersion = (candidate->version == BINARY_LOG_VERSION && candidate->unitsPerDegree == UNITS_PER_DEGREE)
+		|| (candidate->version == 1 && candidate->unitsPerDegree == V1_UNITS_PER_DEGREE);
+	if (!knownVersion || candidate->blockReadings == 0 || candidate->stepSize == 0) {
+		return false;
+	}
+	uint64_t readingSize = GetReadingSize(candidate->version);
+	if (candidate->dataOffset < sizeof(BinaryLogHeader) || candidate->dataOffset % readingSize != 0
+		|| candidate->dataOffset > contents.size()) {
+		return false;
+	}
+
+	//Every reading must lie inside the log (divided rather than multiplied so nothing overflows)
+	uint64_t maxReadings = (contents.size() - candidate->dataOffset) / readingSize;
+	return candidate->numReadings == 0
+		|| (candidate->numCores > 0 && candidate->numReadings <= maxReadings / candidate->numCores);
+}
+
+/**
+ * Converts one core's readings of every block to degrees
+ *
+ * @tparam Units fixed point type the readings are stored as
+ *
+ * @param coreNum specifies which core
+ * @param temps updated with one temperature per reading
+ */
+template<typename Units>
+void BinaryLog::DecodeColumns(int coreNum, std::span<double> temps) const {
+	uint64_t blockReadings = header->blockReadings;
+	double unitsPerDegree = header->unitsPerDegree;
+	const char* data = contents.data() + header->dataOffset;
+
+	for (uint64_t block = 0; block < GetNumBlocks(); block++) {
+		uint64_t first = block * blockReadings;
+		uint64_t count = header->numReadings - first < blockReadings ? header->numReadings - first : blockReadings;
+		const char* column = data + (first * header->numCores + coreNum * count) * sizeof(Units);
+
+		//Divided rather than multiplied by 0.001 so the result matches stod of the text exactly
+		double* out = temps.data() + first;
+		for (uint64_t i = 0; i < count; i++) {
+			Units units;
+			std::memcpy(&units, column + i * sizeof(Units), sizeof(Units));
+			out[i] = units / unitsPerDegree;
+		}
+	}
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Reads the header of a log held in memory. The log is used in place, so
+ * it must outlive this object.
+ *
+ * @param contents the whole log (i.e. MappedFile::Contents)
+ */
+BinaryLog::BinaryLog(std::string_view contents) : contents(contents) {
+	if (Validate()) {
+		header = reinterpret_cast<const BinaryLogHeader*>(contents.data());
+	}
+}
+
+/**
+ * Checks for the magic bytes, without validating the rest of the header
+ *
+ * @param contents start of a log
+ *
+ * @return true if contents starts like a binary log
+ */
+bool BinaryLog::HasMagic(std::string_view contents) {
+	return contents.size() >= 8 && std::memcmp(contents.data(), "CPUTLOG", 8) == 0;
+}
+
+/**
+ * Converts all the readings of one core to degrees
+ *
+ * @param coreNum specifies which core
+ * @param temps updated with one temperature per reading
+ *
+ * @pre IsValid() and temps.size() >= GetNumReadings()
+ */
+void BinaryLog::DecodeCore(int coreNum, std::span<double> temps) const {
+	if (header->version == 1) {
+		DecodeColumns<int16_t>(coreNum, temps);
+	}
+	else {
+		DecodeColumns<int32_t>(coreNum, temps);
+	}
+}
+
+/**
+ * Writes processed readings as a binary log
+ *
+ * @param fileName path of the log to create
+ * @param data provides the temps of every core
+ * @param step_size time-step in seconds
+ *
+ * @return false if the file could not be written, or a reading would not
+ *         survive the fixed point format (more than three decimals);
+ *         nothing is written then
+ */
+bool BinaryLog::Write(const std::string& fileName, const DataPreProcessor& data, int step_size) {
+	uint64_t numCores = data.GetNumCores();
+	uint64_t numReadings = data.GetTimes().size();
+
+	//Encode everything first, so a reading that does not fit leaves no file behind
+	std::vector<int32_t> blocks(numCores * numReadings);
+	for (uint64_t core = 0; core < numCores; core++) {
+		std::span<const double> temps = data.GetCoreReadings(core);
+		for (uint64_t i = 0; i < numReadings; i++) {
+			double scaled = std::round(temps[i] * UNITS_PER_DEGREE);
+			if (!(scaled >= std::numeric_limits<int32_t>::min() && scaled <= std::numeric_limits<int32_t>::max())
+				|| scaled / UNITS_PER_DEGREE != temps[i]) {
+				return false;
+			}
+			uint64_t first = i - i % BLOCK_READINGS;
+			uint64_t count = numReadings - first < BLOCK_READINGS ? numReadings - first : BLOCK_READINGS;
+			blocks[first * numCores + core * count + i - first] = static_cast<int32_t>(scaled);
+		}
+	}
+
+	BinaryLogHeader header = {};
+	std::memcpy(header.magic, "CPUTLOG", 8);
+	header.version = BINARY_LOG_VERSION;
+	header.numCores = numCores;
+	header.stepSize = step_size;
+	header.blockReadings = BLOCK_READINGS;
+	header.unitsPerDegree = UNITS_PER_DEGREE;
+	header.numReadings = numReadings;
+	header.dataOffset = sizeof(BinaryLogHeader);
+
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		return false;
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(int32_t));
+	return static_cast<bool>(out);
+}
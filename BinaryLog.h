@@ -0,0 +1,148 @@
+/**
+ * The Binary Log class reads temperature logs stored in a compact binary
+ * format instead of text, so a log that is analysed over and over is only
+ * tokenised once (by cpuTempsConvert):
+ *
+ *   header  BinaryLogHeader (64 bytes)
+ *   blocks  numBlocks x (numCores columns of int32 x blockReadings)
+ *
+ * Readings are fixed point: the temperature in thousandths of a degree, the
+ * resolution of the sensors and of LiveSampler's logs. Each block holds
+ * blockReadings consecutive lines, one column per core; the last block holds
+ * whatever lines are left. Times are not stored, reading i was taken at
+ * i * stepSize. Values are stored in the machine's native (little-endian on
+ * x86) byte order.
+ *
+ * A reading of a text log with at most three decimals (i.e. +61.125°C) is
+ * stored exactly, and dividing it by 1000 gives back the same double stod
+ * does. Version 1 logs hold int16 hundredths of a degree instead, and are
+ * still read.
+ */
+#ifndef BINARY_LOG_H_INCLUDED
+#define BINARY_LOG_H_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+class DataPreProcessor;
+
+/**
+ * Fixed size header at the start of every binary log
+ */
+struct BinaryLogHeader
+{
+	char magic[8]; //!< "CPUTLOG" followed by a 0
+	uint32_t version; //!< Format version (BINARY_LOG_VERSION)
+	uint32_t numCores; //!< Number of core columns in every block
+	uint32_t stepSize; //!< Seconds between two readings
+	uint32_t blockReadings; //!< Readings of each core in one block
+	uint32_t unitsPerDegree; //!< Fixed point scale of the readings (1000, 100 in version 1)
+	uint32_t reserved0; //!< Zero
+	uint64_t numReadings; //!< Number of lines
+	uint64_t dataOffset; //!< Where the first block starts
+	uint64_t reserved1[2]; //!< Zero
+};
+static_assert(sizeof(BinaryLogHeader) == 64, "binary log header must stay 64 bytes");
+
+class BinaryLog
+{
+private:
+
+	static constexpr uint32_t BINARY_LOG_VERSION = 2; //!< Version written by this code
+	static constexpr uint32_t BLOCK_READINGS = 4096; //!< Readings per core in the blocks written by this code
+	static constexpr uint32_t UNITS_PER_DEGREE = 1000; //!< Readings are stored in thousandths of a degree
+	static constexpr uint32_t V1_UNITS_PER_DEGREE = 100; //!< Version 1 logs store hundredths of a degree
+
+	std::string_view contents; //!< The whole log (i.e. MappedFile::Contents)
+	const BinaryLogHeader* header = nullptr; //!< Header of the log (nullptr if it is not valid)
+
+	/**
+	 * Checks the header and that every block lies inside the log
+	 *
+	 * @return false if contents is not a binary log this code can read
+	 */
+	bool Validate() const;
+
+	/**
+	 * Fetches the number of blocks that hold the readings
+	 *
+	 * @return the number of blocks
+	 */
+	uint64_t GetNumBlocks() const { return (header->numReadings + header->blockReadings - 1) / header->blockReadings; }
+
+	/**
+	 * Fetches the size of one stored reading
+	 *
+	 * @param version format version of the log
+	 *
+	 * @return bytes per reading (int16 in version 1, int32 since)
+	 */
+	static uint64_t GetReadingSize(uint32_t version) { return version == 1 ? sizeof(int16_t) : sizeof(int32_t); }
+
+	/**
+	 * Converts one core's readings of every block to degrees
+	 *
+	 * @tparam Units fixed point type the readings are stored as
+	 *
+	 * @param coreNum specifies which core
+	 * @param temps updated with one temperature per reading
+	 */
+	template<typename Units>
+	void DecodeColumns(int coreNum, std::span<double> temps) const;
+
+public:
+
+	/**
+	 * Reads the header of a log held in memory. The log is used in place, so
+	 * it must outlive this object.
+	 *
+	 * @param contents the whole log (i.e. MappedFile::Contents)
+	 */
+	BinaryLog(std::string_view contents);
+
+	/**
+	 * Checks for the magic bytes, without validating the rest of the header
+	 *
+	 * @param contents start of a log
+	 *
+	 * @return true if contents starts like a binary log
+	 */
+	static bool HasMagic(std::string_view contents);
+
+	/**
+	 * Reports if the log is a binary log this code can read
+	 *
+	 * @return false if the header or the size of the log is wrong
+	 */
+	bool IsValid() const { return header != nullptr; }
+
+	int GetNumCores() const { return header->numCores; }
+	int GetStepSize() const { return header->stepSize; }
+	uint64_t GetNumReadings() const { return header->numReadings; }
+
+	/**
+	 * Converts all the readings of one core to degrees
+	 *
+	 * @param coreNum specifies which core
+	 * @param temps updated with one temperature per reading
+	 *
+	 * @pre IsValid() and temps.size() >= GetNumReadings()
+	 */
+	void DecodeCore(int coreNum, std::span<double> temps) const;
+
+	/**
+	 * Writes processed readings as a binary log
+	 *
+	 * @param fileName path of the log to create
+	 * @param data provides the temps of every core
+	 * @param step_size time-step in seconds
+	 *
+	 * @return false if the file could not be written, or a reading would not
+	 *         survive the fixed point format (more than three decimals);
+	 *         nothing is written then
+	 */
+	static bool Write(const std::string& fileName, const DataPreProcessor& data, int step_size = 30);
+};
+#endif
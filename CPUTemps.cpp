@@ -3,99 +3,712 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <atomic>
+#include <csignal>
+#include <stdexcept>
 
 #include "parseTemps.h"
+#include "MappedTempParser.h"
 #include "DataPreProcessor.h"
 #include "PiecewiseLinearInterpolation.h"
 #include "LeastSquaresApproximation.h"
+#include "PolynomialLeastSquares.h"
+#include "AdaptiveSegmentation.h"
+#include "UniformStepEngine.h"
+#include "RollingTrend.h"
+#include "CoreCorrelation.h"
+#include "LogFollower.h"
+#include "SensorSampler.h"
+#include "LiveSampler.h"
+#include "AnalysisDaemon.h"
+#include "ChunkedLogProcessor.h"
+#include "ModelFile.h"
+#include "BinaryLog.h"
+#include "ReportWriter.h"
+#include "AsyncReportWriter.h"
+#include "ThreadPool.h"
+#include "PipelineStats.h"
+#include "PipelineArena.h"
 
 using namespace std;
 
 using CoreTempReading = std::pair<int, std::vector<double>>;
 using SlopeAndIntercept = std::pair<double, double>;
 
-void outputOrganizer(const string& core0Output, const string& core1Output, 
-                     const string& core2Output, const string& core3Output, const string& inputFileName) {
-    
-    string fn = inputFileName;
-    //Get only the filename of the base file (no extensions)
-    size_t extensionSpot = fn.find_last_of('.');
-    if (extensionSpot != std::string::npos) {
-        if (extensionSpot > 1) {
-            fn = fn.substr(0, extensionSpot - 1);
+const int MAX_DEGREE = 5; // Highest polynomial degree accepted by --degree (the printed monomial coefficients mean little past it)
+
+// Settings taken from the command line
+struct RunOptions {
+    int numThreads = 1;
+    int degree = 1;
+    bool follow = false;
+    bool binary = false; // Also write <base>-model.bin
+    bool correlation = false; // Also write <base>-correlation.txt
+    bool toText = false; // Inputs are model files to turn back into text reports
+    bool stats = false; // Print a JSON summary of stage timings and counts
+    int trendWindow = 0; // Width of the rolling least squares window, 0 for none
+    bool trendInSeconds = false; // Whether trendWindow is in seconds rather than samples
+    double segmentTolerance = 0.0; // Error allowed per adaptive segment, 0 for plain interpolations
+    SegmentError segmentError = SegmentError::Max; // How the adaptive segment error is measured
+    bool uniform = false; // Use UniformStepEngine when the log has a step and core count it covers
+    size_t chunkBytes = 0; // Read the log this many bytes at a time instead of all at once, 0 for in memory
+    string serveSocket; // Run as a daemon on this Unix domain socket, empty for none
+    string clientSocket; // Send the input arguments as a request to the daemon on this socket, empty for none
+    bool sample = false; // Sample the sysfs sensors into the input file instead of reading it
+    int sampleInterval = 30; // Seconds between two samples (the step every log is read with)
+    uint64_t sampleCount = 0; // Samples to take before stopping, 0 for until interrupted
+    string sysfsRoot = "/sys"; // Where the sensors are looked for (a fake tree for testing)
+};
+
+// Interpolation lines formatted before they are handed to the report writer,
+// so writing starts while the rest of the report is still being formatted
+const size_t REPORT_CHUNK_LINES = 16384;
+
+// Runs the polynomial least squares for one core and streams its report,
+// together with the core's interpolations and linear least squares fit, to
+// the core's stream of reportWriter a chunk of lines at a time.
+// A degree above 1 adds a polynomial least squares line to the report.
+// A segment tolerance replaces the interpolations with adaptive segments,
+// whose count is handed back through numSegments.
+// Cores share nothing but the read-only processed data and the writer, so
+// this is safe to run for several cores at once.
+void analyzeCore(const DataPreProcessor& processedData, const InterpolationTable& interpolations, int core,
+                 const RunOptions& options, const SlopeAndIntercept& coreFit, size_t& numSegments,
+                 AsyncReportWriter& reportWriter, int stream, PipelineStats* stats) {
+    PiecewiseLinearInterpolation interpolationCalculator;
+    LeastSquaresApproximation leastSquareCalculator;
+    AdaptiveSegmentation segmentation(options.segmentTolerance, options.segmentError);
+    int degree = options.degree;
+
+    std::span<const int> times = processedData.GetTimes();
+    std::span<const double> temps = processedData.GetCoreReadings(core);
+
+    numSegments = interpolations.GetNumSegments();
+    if (options.segmentTolerance > 0.0) {
+        PipelineStats::StageTimer timer(stats, PipelineStage::Interpolate);
+        segmentation.Calculate(times, temps);
+        numSegments = segmentation.GetNumSegments();
+    }
+
+    std::vector<double> polynomial;
+    if (degree > 1) {
+        PipelineStats::StageTimer timer(stats, PipelineStage::Fit);
+        polynomial = PolynomialLeastSquares(degree).Calculate(times, temps);
+    }
+
+    PipelineStats::StageTimer timer(stats, PipelineStage::Format);
+    ReportFormatter coreReport;
+    if (options.segmentTolerance > 0.0) {
+        coreReport.Reserve(numSegments + 1);
+        segmentation.AppendTo(coreReport, times);
+    }
+    else {
+        //Each chunk covers lines [first, first + count), which need the times up to first + count
+        std::span<const double> slopes = interpolations.GetSlopes(core);
+        std::span<const double> intercepts = interpolations.GetIntercepts(core);
+        for (size_t first = 0; first < slopes.size(); first += REPORT_CHUNK_LINES) {
+            size_t count = min(REPORT_CHUNK_LINES, slopes.size() - first);
+            coreReport.Clear();
+            interpolationCalculator.AppendTo(coreReport, slopes.subspan(first, count), intercepts.subspan(first, count),
+                                             times.subspan(first, count + 1), first);
+            if (first + count < slopes.size()) {
+                reportWriter.Append(stream, coreReport.View());
+            }
         }
     }
+    leastSquareCalculator.AppendTo(coreReport, coreFit, times);
+
+    if (degree > 1) {
+        PolynomialLeastSquares(degree).AppendTo(coreReport, polynomial, times);
+    }
+    reportWriter.Append(stream, coreReport.View());
+}
+
+// Cleared by SIGINT/SIGTERM to end --follow and --serve
+atomic<bool> keepRunning = true;
+
+void stopRunning(int) {
+    keepRunning = false;
+}
+
+// Keeps the reports of a growing log up to date until interrupted.
+// Returns the program exit code.
+int followFile(const string& inputFileName) {
+    LogFollower follower(inputFileName);
+    if (!follower.Update()) {
+        cout << "ERROR: " << inputFileName << " could not be opened" << "\n";
+        return 2;
+    }
 
-    std::ofstream core0Out(fn + "-core-0.txt");
-    core0Out << core0Output;
-    core0Out.close();
+    signal(SIGINT, stopRunning);
+    signal(SIGTERM, stopRunning);
+    if (!follower.Follow(keepRunning)) {
+        cout << "ERROR: " << inputFileName << " could not be followed" << "\n";
+        return 3;
+    }
+    return 0;
+}
 
-    std::ofstream core1Out(fn + "-core-1.txt");
-    core1Out << core1Output;
-    core1Out.close();
+// Samples every hwmon and thermal sensor into a text log and keeps its
+// reports up to date until interrupted (or the sample count is reached).
+// Returns the program exit code.
+int sampleSensors(const string& logName, const RunOptions& options) {
+    SensorSampler sensors(options.sysfsRoot);
+    if (sensors.GetNumSensors() == 0) {
+        cout << "ERROR: no temperature sensors found under " << options.sysfsRoot << "\n";
+        return 2;
+    }
+    cout << "Sampling " << sensors.GetNumSensors() << " sensors every " << options.sampleInterval << " s into " << logName << "\n";
+    for (int sensor = 0; sensor < sensors.GetNumSensors(); sensor++) {
+        cout << "  core " << sensor << ": " << sensors.GetSensorNames()[sensor] << "\n";
+    }
 
-    std::ofstream core2Out(fn + "-core-2.txt");
-    core2Out << core2Output;
-    core2Out.close();
+    LiveSampler sampler(sensors, logName, options.sampleInterval, options.sampleCount);
+    signal(SIGINT, stopRunning);
+    signal(SIGTERM, stopRunning);
+    bool succeeded = sampler.Run(keepRunning);
+    cout << "Took " << sampler.GetNumSamples() << " samples (" << sampler.GetNumDropped() << " dropped)" << "\n";
+    if (!succeeded) {
+        cout << "ERROR: " << logName << " or its reports could not be written" << "\n";
+        return 3;
+    }
+    return 0;
+}
 
-    std::ofstream core3Out(fn + "-core-3.txt");
-    core3Out << core3Output;
-    core3Out.close();
+// Keeps logs and their models in memory and answers requests about them on
+// a Unix domain socket until interrupted. Returns the program exit code.
+int serveRequests(const string& socketPath, int numThreads) {
+    AnalysisDaemon daemon(socketPath, numThreads);
+    if (!daemon.Listen()) {
+        cout << "ERROR: could not serve on " << socketPath << "\n";
+        return 2;
+    }
+
+    signal(SIGINT, stopRunning);
+    signal(SIGTERM, stopRunning);
+    if (!daemon.Serve(keepRunning)) {
+        cout << "ERROR: serving on " << socketPath << " failed" << "\n";
+        return 3;
+    }
+    return 0;
+}
+
+// Sends one request to a daemon started with --serve and prints the response.
+// Log paths are made absolute first, since the daemon runs in another
+// directory. Returns the program exit code.
+int sendRequest(const string& socketPath, vector<string> words) {
+    if (words.size() > 1 && (words[0] == "fit" || words[0] == "eval" || words[0] == "refresh")) {
+        std::error_code error;
+        filesystem::path logPath = filesystem::absolute(words[1], error);
+        if (!error) {
+            words[1] = logPath.lexically_normal().string();
+        }
+    }
+    string request;
+    for (const string& word : words) {
+        request += (request.empty() ? "" : " ") + word;
+    }
+
+    string response;
+    if (!AnalysisDaemon::Request(socketPath, request, response)) {
+        cout << "ERROR: no daemon answered on " << socketPath << "\n";
+        return 2;
+    }
+    //Drop the empty line that ends every response
+    cout << response.substr(0, response.size() - 1);
+    return response.starts_with("OK") ? 0 : 3;
+}
+
+// What one input file contributed to a run
+struct FileResult {
+    bool opened = false;
+    size_t bytesRead = 0;
+    size_t numSamples = 0;
+    size_t numInterpolations = 0; // Per-sample interpolations across all cores
+    size_t numSegments = 0; // Lines in the reports, fewer than numInterpolations with adaptive segments
+    bool written = false; // Whether every report (and the model file with --binary) was written
+    bool parsed = true; // Whether every token of the log was a number
+};
+
+// Parses, analyses and writes the reports of one input file. When corePool is
+// given the cores are analysed on it, otherwise one after another.
+// The columns and interpolations are allocated from arena, which the
+// caller resets once the file is done. Only this thread allocates from it.
+FileResult processFile(const string& inputFileName, const RunOptions& options, ThreadPool* corePool, PipelineStats* stats,
+                       PipelineArena& arena) {
+    FileResult result;
+    MappedTempParser input_temps(inputFileName);
+    if (!input_temps.IsOpen()) {
+        return result;
+    }
+    result.opened = true;
+    result.bytesRead = input_temps.Contents().size();
+
+    //A binary log is not a text log gone wrong, so a damaged one is not parsed as text
+    BinaryLog binaryLog(input_temps.Contents());
+    if (BinaryLog::HasMagic(input_temps.Contents()) && !binaryLog.IsValid()) {
+        result.opened = false;
+        return result;
+    }
+
+    //Parse straight into the core columns, no per-line readings in between.
+    //Binary logs are only converted from fixed point.
+    DataPreProcessor processedData = [&input_temps, &binaryLog, &arena, stats] {
+        PipelineStats::StageTimer timer(stats, PipelineStage::Parse);
+        if (binaryLog.IsValid()) {
+            return DataPreProcessor(binaryLog, &arena);
+        }
+        return DataPreProcessor(input_temps.Contents(), 30, &arena);
+    }();
+
+    int numCores = processedData.GetNumCores();
+    result.numSamples = processedData.GetTimes().size() * numCores;
+    std::vector<SlopeAndIntercept> coreFits(numCores);
+    std::vector<size_t> coreSegments(numCores);
+
+    //Interpolations of every core in one batch pass
+    PiecewiseLinearInterpolation interpolationCalculator;
+    InterpolationTable interpolations(&arena);
+    const UniformStepFunctions* uniformEngine = options.uniform ? FindUniformStepEngine(processedData) : nullptr;
+    {
+        PipelineStats::StageTimer timer(stats, PipelineStage::Interpolate);
+        if (uniformEngine != nullptr) {
+            uniformEngine->Interpolate(interpolations, processedData);
+        }
+        else {
+            interpolationCalculator.Calculate(interpolations, processedData);
+        }
+    }
+
+    //Linear fits of every core share one xTx, so they are solved together
+    {
+        PipelineStats::StageTimer timer(stats, PipelineStage::Fit);
+        if (uniformEngine != nullptr) {
+            uniformEngine->Fit(coreFits, processedData);
+        }
+        else {
+            LeastSquaresApproximation(&arena).Calculate(coreFits, processedData);
+        }
+    }
+
+    //Each core streams to its own report, written while the next chunk is formatted
+    AsyncReportWriter reportWriter;
+    std::vector<int> coreStreams(numCores);
+    for (int core = 0; core < numCores; core++) {
+        coreStreams[core] = reportWriter.Open(coreReportName(inputFileName, core));
+    }
+    if (corePool != nullptr && numCores > 1) {
+        for (int core = 0; core < numCores; core++) {
+            corePool->Submit([&processedData, &interpolations, &options, &coreFits, &coreSegments, &reportWriter, &coreStreams, core, stats] {
+                analyzeCore(processedData, interpolations, core, options, coreFits[core], coreSegments[core],
+                            reportWriter, coreStreams[core], stats);
+            });
+        }
+        corePool->Wait();
+    }
+    else {
+        for (int core = 0; core < numCores; core++) {
+            analyzeCore(processedData, interpolations, core, options, coreFits[core], coreSegments[core],
+                        reportWriter, coreStreams[core], stats);
+        }
+    }
+    result.numInterpolations = interpolations.GetNumSegments() * numCores;
+    for (size_t segments : coreSegments) {
+        result.numSegments += segments;
+    }
+
+    //Rolling trend of every core, in one pass over the readings
+    if (options.trendWindow > 0) {
+        RollingTrend trend(options.trendWindow, options.trendInSeconds);
+        {
+            PipelineStats::StageTimer timer(stats, PipelineStage::Fit);
+            trend.Calculate(processedData);
+        }
+
+        PipelineStats::StageTimer timer(stats, PipelineStage::Format);
+        string trendBaseName = outputBaseName(inputFileName) + "-trend";
+        for (int core = 0; core < numCores; core++) {
+            ReportFormatter trendReport;
+            trend.AppendTo(trendReport, core);
+            reportWriter.Append(reportWriter.Open(trendBaseName + "-core-" + to_string(core) + ".txt"), trendReport.View());
+        }
+    }
+
+    //Covariance and correlation of every pair of cores, in one pass over the readings
+    if (options.correlation) {
+        CoreCorrelation correlation;
+        {
+            PipelineStats::StageTimer timer(stats, PipelineStage::Fit);
+            correlation.Calculate(processedData, corePool);
+        }
+
+        PipelineStats::StageTimer timer(stats, PipelineStage::Format);
+        ReportFormatter correlationReport;
+        correlation.AppendTo(correlationReport);
+        reportWriter.Append(reportWriter.Open(correlationReportName(inputFileName)), correlationReport.View());
+    }
+
+    //Only what is still queued is left to wait for
+    PipelineStats::StageTimer timer(stats, PipelineStage::Write);
+    result.written = reportWriter.Finish();
+    if (options.binary && !ModelFile::Write(modelFileName(inputFileName), processedData.GetTimes(), interpolations, coreFits)) {
+        result.written = false;
+    }
+
+    if (stats != nullptr) {
+        stats->AddFile(result.bytesRead, result.numSamples, result.numSegments);
+        stats->AddBytesWritten(reportWriter.GetBytesWritten());
+        if (options.binary) {
+            std::error_code error;
+            uintmax_t modelSize = filesystem::file_size(modelFileName(inputFileName), error);
+            stats->AddBytesWritten(error ? 0 : modelSize);
+        }
+    }
+    return result;
+}
+
+// Runs processFile, turning a log holding a token that is not a number into a
+// result saying so rather than an exception, so one bad log only fails itself
+FileResult tryProcessFile(const string& inputFileName, const RunOptions& options, ThreadPool* corePool, PipelineStats* stats,
+                          PipelineArena& arena) {
+    try {
+        return processFile(inputFileName, options, corePool, stats, arena);
+    }
+    catch (const invalid_argument&) {
+    }
+    catch (const out_of_range&) {
+    }
+    FileResult result;
+    result.opened = true;
+    result.parsed = false;
+    return result;
+}
+
+// Prints how far adaptive segmentation shrank the interpolations, so the
+// tolerance can be tuned
+void printCompression(size_t numSegments, size_t numInterpolations) {
+    double ratio = numSegments > 0 ? static_cast<double>(numInterpolations) / numSegments : 0.0;
+    cout << fixed << setprecision(2)
+         << "Compression: " << numSegments << " segments for " << numInterpolations << " interpolations ("
+         << ratio << "x)" << "\n";
+}
+
+// Rebuilds the text reports stored in binary model files, next to each model
+// file. Returns the program exit code.
+int convertModels(const vector<string>& modelFiles) {
+    int exitCode = 0;
+    for (const string& modelName : modelFiles) {
+        ModelFile model(modelName);
+        if (!model.IsValid()) {
+            cout << "ERROR: " << modelName << " is not a model file" << "\n";
+            exitCode = 2;
+            continue;
+        }
+
+        std::vector<string> coreReports(model.GetNumCores());
+        for (int core = 0; core < model.GetNumCores(); core++) {
+            coreReports[core] = model.ToString(core);
+        }
+        writeCoreReports(coreReports, modelBaseName(modelName));
+    }
+    return exitCode;
+}
+
+// Expands the input arguments into the list of logs to process. Directories
+// contribute every regular file inside them, except reports and models written
+// by a previous run (<name>-core-N.txt, <name>-model.bin, <name>-correlation.txt).
+vector<string> collectInputFiles(const vector<string>& inputArgs) {
+    vector<string> inputFiles;
+    for (const string& inputArg : inputArgs) {
+        std::error_code error;
+        if (!filesystem::is_directory(inputArg, error)) {
+            inputFiles.push_back(inputArg);
+            continue;
+        }
+
+        vector<string> directoryFiles;
+        for (const filesystem::directory_entry& entry : filesystem::directory_iterator(inputArg, error)) {
+            string fileName = entry.path().filename().string();
+            if (entry.is_regular_file(error) && fileName.find("-core-") == string::npos && !fileName.ends_with("-model.bin")
+                && !fileName.ends_with("-correlation.txt")) {
+                directoryFiles.push_back(entry.path().string());
+            }
+        }
+        sort(directoryFiles.begin(), directoryFiles.end());
+        inputFiles.insert(inputFiles.end(), directoryFiles.begin(), directoryFiles.end());
+    }
+    return inputFiles;
+}
+
+// Processes many logs at once, one task per file on a work-stealing pool, and
+// prints the aggregate throughput. Returns the program exit code.
+int processBatch(const vector<string>& inputFiles, const RunOptions& options, PipelineStats* stats) {
+    //Start the largest files first so small ones fill in the gaps at the end
+    vector<pair<uintmax_t, size_t>> schedule;
+    for (size_t i = 0; i < inputFiles.size(); i++) {
+        std::error_code error;
+        uintmax_t size = filesystem::file_size(inputFiles[i], error);
+        schedule.emplace_back(error ? 0 : size, i);
+    }
+    stable_sort(schedule.begin(), schedule.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first;
+    });
+
+    vector<FileResult> results(inputFiles.size());
+    auto start = chrono::steady_clock::now();
+    {
+        ThreadPool filePool(options.numThreads);
+        for (const auto& scheduled : schedule) {
+            size_t fileIndex = scheduled.second;
+            filePool.Submit([&inputFiles, &options, &results, fileIndex, stats] {
+                //Each worker keeps one arena and reuses it for every file it takes
+                static thread_local PipelineArena arena;
+                results[fileIndex] = tryProcessFile(inputFiles[fileIndex], options, nullptr, stats, arena);
+                arena.Reset();
+            });
+        }
+        filePool.Wait();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    int exitCode = 0;
+    size_t numFiles = 0;
+    size_t totalBytes = 0;
+    size_t totalSamples = 0;
+    size_t totalInterpolations = 0;
+    size_t totalSegments = 0;
+    for (size_t i = 0; i < inputFiles.size(); i++) {
+        if (!results[i].opened) {
+            cout << "ERROR: " << inputFiles[i] << " could not be opened" << "\n";
+            exitCode = 2;
+            continue;
+        }
+        if (!results[i].parsed) {
+            cout << "ERROR: " << inputFiles[i] << " could not be parsed" << "\n";
+            exitCode = 2;
+            continue;
+        }
+        if (!results[i].written) {
+            cout << "ERROR: reports of " << inputFiles[i] << " could not be written" << "\n";
+            exitCode = 3;
+        }
+        numFiles++;
+        totalBytes += results[i].bytesRead;
+        totalSamples += results[i].numSamples;
+        totalInterpolations += results[i].numInterpolations;
+        totalSegments += results[i].numSegments;
+    }
+
+    double megabytes = totalBytes / 1e6;
+    double elapsed = seconds > 0.0 ? seconds : 1e-9;
+    cout << fixed << setprecision(3)
+         << "Processed " << numFiles << " files (" << megabytes << " MB, " << totalSamples << " samples) in "
+         << seconds << " s: " << megabytes / elapsed << " MB/s, "
+         << setprecision(0) << totalSamples / elapsed << " samples/s" << "\n";
+    if (options.segmentTolerance > 0.0) {
+        printCompression(totalSegments, totalInterpolations);
+    }
+    return exitCode;
+}
+
+// Checks the first bytes of a file for the binary log magic, without mapping it
+bool startsAsBinaryLog(const string& inputFileName) {
+    char magic[8] = {};
+    ifstream input(inputFileName, ios::binary);
+    input.read(magic, sizeof(magic));
+    return BinaryLog::HasMagic(string_view(magic, input.gcount()));
 }
 
 int main(int argc, char** argv)
 {
     // Input validation
-    if (argc < 2) {
-        cout << "Usage: " << argv[0] << " input_file_name" << "\n";
+    RunOptions options;
+    vector<string> inputArgs;
+    bool chunkedMode = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            options.numThreads = atoi(argv[++i]);
+            if (options.numThreads < 1) {
+                options.numThreads = ThreadPool::HardwareThreads();
+            }
+        }
+        else if (arg == "--degree" && i + 1 < argc) {
+            options.degree = atoi(argv[++i]);
+        }
+        else if (arg == "--follow") {
+            options.follow = true;
+        }
+        else if (arg == "--binary") {
+            options.binary = true;
+        }
+        else if (arg == "--correlation") {
+            options.correlation = true;
+        }
+        else if (arg == "--to-text") {
+            options.toText = true;
+        }
+        else if (arg == "--uniform") {
+            options.uniform = true;
+        }
+        else if (arg == "--chunk-mb" && i + 1 < argc) {
+            // Fractions are allowed, i.e. --chunk-mb 0.5
+            double megabytes = atof(argv[++i]);
+            options.chunkBytes = megabytes > 0.0 ? static_cast<size_t>(megabytes * 1e6) : 0;
+            chunkedMode = true;
+        }
+        else if (arg == "--stats") {
+            options.stats = true;
+        }
+        else if (arg == "--sample") {
+            options.sample = true;
+        }
+        else if (arg == "--interval" && i + 1 < argc) {
+            options.sampleInterval = atoi(argv[++i]);
+        }
+        else if (arg == "--count" && i + 1 < argc) {
+            options.sampleCount = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--sysfs-root" && i + 1 < argc) {
+            options.sysfsRoot = argv[++i];
+        }
+        else if (arg == "--serve" && i + 1 < argc) {
+            options.serveSocket = argv[++i];
+        }
+        else if (arg == "--client" && i + 1 < argc) {
+            options.clientSocket = argv[++i];
+        }
+        else if (arg == "--trend" && i + 1 < argc) {
+            // A trailing s gives the window in seconds, i.e. --trend 600s
+            string window = argv[++i];
+            options.trendInSeconds = !window.empty() && window.back() == 's';
+            options.trendWindow = atoi(window.c_str());
+            if (options.trendWindow < (options.trendInSeconds ? 1 : 2)) {
+                options.trendWindow = -1;
+            }
+        }
+        else if ((arg == "--max-error" || arg == "--rms-error") && i + 1 < argc) {
+            options.segmentError = arg == "--max-error" ? SegmentError::Max : SegmentError::Rms;
+            options.segmentTolerance = atof(argv[++i]);
+            if (options.segmentTolerance <= 0.0) {
+                options.segmentTolerance = -1.0;
+            }
+        }
+        else {
+            inputArgs.push_back(arg);
+        }
+    }
+
+    if ((inputArgs.empty() == options.serveSocket.empty()) || (!options.serveSocket.empty() && !options.clientSocket.empty())
+        || options.degree < 1 || options.degree > MAX_DEGREE || options.trendWindow < 0
+        || options.segmentTolerance < 0.0 || (options.follow && inputArgs.size() > 1)
+        || (options.sample && (inputArgs.size() != 1 || options.sampleInterval < 1 || options.follow))
+        || (chunkedMode && (options.chunkBytes == 0 || inputArgs.size() != 1 || options.degree > 1 || options.trendWindow > 0
+                            || options.segmentTolerance > 0.0 || options.uniform || options.binary || options.follow
+                            || options.toText || filesystem::is_directory(inputArgs[0])))) {
+        cout << "Usage: " << argv[0] << " [--threads N] [--degree K] [--trend N[s]] [--max-error T | --rms-error T] [--uniform] [--binary] [--correlation] [--stats] input_file_name..." << "\n";
+        cout << "       " << argv[0] << " --chunk-mb M [--threads N] [--correlation] [--stats] input_file_name" << "\n";
+        cout << "       " << argv[0] << " --follow input_file_name" << "\n";
+        cout << "       " << argv[0] << " --sample [--interval S] [--count N] [--sysfs-root DIR] output_log_name" << "\n";
+        cout << "       " << argv[0] << " --to-text model_file_name..." << "\n";
+        cout << "       " << argv[0] << " --serve socket_path [--threads N]" << "\n";
+        cout << "       " << argv[0] << " --client socket_path fit|eval|refresh|stats [arguments...]" << "\n";
         return 1;
     }
 
-    ifstream input_temps(argv[1]);
-    if (!input_temps) {
-        cout << "ERROR: " << argv[1] << " could not be opened" << "\n";
-        return 2;
+    if (!options.serveSocket.empty()) {
+        return serveRequests(options.serveSocket, options.numThreads);
+    }
+
+    if (!options.clientSocket.empty()) {
+        return sendRequest(options.clientSocket, inputArgs);
+    }
+
+    if (options.toText) {
+        return convertModels(inputArgs);
+    }
+
+    if (options.follow) {
+        return followFile(inputArgs[0]);
+    }
+
+    if (options.sample) {
+        return sampleSensors(inputArgs[0], options);
+    }
+
+    unique_ptr<PipelineStats> stats;
+    if (options.stats) {
+        stats = make_unique<PipelineStats>();
+    }
+
+    //Several files or a directory run as a batch
+    std::error_code error;
+    if (inputArgs.size() > 1 || filesystem::is_directory(inputArgs[0], error)) {
+        int exitCode = processBatch(collectInputFiles(inputArgs), options, stats.get());
+        if (stats) {
+            cout << stats->ToJson();
+        }
+        return exitCode;
     }
     // End Input Validation
 
-    // vector
-    auto readings = parse_raw_temps<std::vector<CoreTempReading>>(input_temps);
-    DataPreProcessor processedData(readings);
+    unique_ptr<ThreadPool> corePool;
+    if (options.numThreads > 1) {
+        corePool = make_unique<ThreadPool>(options.numThreads);
+    }
 
-    //Declare variables
-    PiecewiseLinearInterpolation interpolationCalculator;
-    LeastSquaresApproximation leastSquareCalculator;
+    //Logs bigger than memory are read and processed a chunk per worker at a time.
+    //Binary logs need no tokenising, so they always go through the mapped pipeline.
+    if (options.chunkBytes > 0 && !startsAsBinaryLog(inputArgs[0])) {
+        ChunkedLogProcessor processor(inputArgs[0], options.chunkBytes, corePool.get(), stats.get(), options.correlation);
+        bool finished = false;
+        try {
+            finished = processor.Run();
+        }
+        catch (const invalid_argument&) {
+            cout << "ERROR: " << inputArgs[0] << " could not be parsed" << "\n";
+            return 2;
+        }
+        catch (const out_of_range&) {
+            cout << "ERROR: " << inputArgs[0] << " could not be parsed" << "\n";
+            return 2;
+        }
+        if (!processor.IsOpen()) {
+            cout << "ERROR: " << inputArgs[0] << " could not be opened" << "\n";
+            return 2;
+        }
+        if (!finished) {
+            cout << "ERROR: reports of " << inputArgs[0] << " could not be written" << "\n";
+            return 3;
+        }
+        if (stats) {
+            cout << stats->ToJson();
+        }
+        return 0;
+    }
 
-    std::vector<SlopeAndIntercept> core0LineParts;
-    std::vector<SlopeAndIntercept> core1LineParts;
-    std::vector<SlopeAndIntercept> core2LineParts;
-    std::vector<SlopeAndIntercept> core3LineParts;
-
-    SlopeAndIntercept core0SquareApprox;
-    SlopeAndIntercept core1SquareApprox;
-    SlopeAndIntercept core2SquareApprox;
-    SlopeAndIntercept core3SquareApprox;
-
-    //Initialize Variables
-    interpolationCalculator.Calculate(core0LineParts, processedData.GetTimes(), processedData.GetCoreReadings(0));
-    interpolationCalculator.Calculate(core1LineParts, processedData.GetTimes(), processedData.GetCoreReadings(1));
-    interpolationCalculator.Calculate(core2LineParts, processedData.GetTimes(), processedData.GetCoreReadings(2));
-    interpolationCalculator.Calculate(core3LineParts, processedData.GetTimes(), processedData.GetCoreReadings(3));
-
-    core0SquareApprox = leastSquareCalculator.Calculate(processedData.GetTimes(), processedData.GetCoreReadings(0));
-    core1SquareApprox = leastSquareCalculator.Calculate(processedData.GetTimes(), processedData.GetCoreReadings(1));
-    core2SquareApprox = leastSquareCalculator.Calculate(processedData.GetTimes(), processedData.GetCoreReadings(2));
-    core3SquareApprox = leastSquareCalculator.Calculate(processedData.GetTimes(), processedData.GetCoreReadings(3));
-
-    //Output information
-    string core0Report = interpolationCalculator.ToString(core0LineParts, processedData.GetTimes()) 
-                            + leastSquareCalculator.ToString(core0SquareApprox, processedData.GetTimes());
-    string core1Report = interpolationCalculator.ToString(core1LineParts, processedData.GetTimes())
-                            + leastSquareCalculator.ToString(core1SquareApprox, processedData.GetTimes());
-    string core2Report = interpolationCalculator.ToString(core2LineParts, processedData.GetTimes())
-                            + leastSquareCalculator.ToString(core2SquareApprox, processedData.GetTimes());
-    string core3Report = interpolationCalculator.ToString(core3LineParts, processedData.GetTimes())
-                            + leastSquareCalculator.ToString(core3SquareApprox, processedData.GetTimes());
-
-    outputOrganizer(core0Report, core1Report, core2Report, core3Report, argv[1]);
-}
\ No newline at end of file
+    PipelineArena arena;
+    FileResult result = tryProcessFile(inputArgs[0], options, corePool.get(), stats.get(), arena);
+    if (!result.opened) {
+        cout << "ERROR: " << inputArgs[0] << " could not be opened" << "\n";
+        return 2;
+    }
+    if (!result.parsed) {
+        cout << "ERROR: " << inputArgs[0] << " could not be parsed" << "\n";
+        return 2;
+    }
+    if (!result.written) {
+        cout << "ERROR: reports of " << inputArgs[0] << " could not be written" << "\n";
+        return 3;
+    }
+    if (options.segmentTolerance > 0.0) {
+        printCompression(result.numSegments, result.numInterpolations);
+    }
+    if (stats) {
+        cout << stats->ToJson();
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * Allocator that starts every allocation on a cache line boundary, so a
+ * column of readings never shares its first cache line with other data.
+ * Storage comes from a std::pmr memory resource (the default resource
+ * unless one is given, i.e. a PipelineArena).
+ */
+#ifndef CACHE_ALIGNED_ALLOCATOR_H_INCLUDED
+#define CACHE_ALIGNED_ALLOCATOR_H_INCLUDED
+
+#include <cstddef>
+#include <memory_resource>
+
+constexpr std::size_t CACHE_LINE_SIZE = 64; //!< Bytes in one cache line
+
+template<typename T>
+class CacheAlignedAllocator
+{
+private:
+
+	template<typename U>
+	friend class CacheAlignedAllocator;
+
+	std::pmr::memory_resource* resource; //!< Where the storage comes from
+
+public:
+
+	using value_type = T;
+
+	/**
+	 * Creates an allocator that draws from a memory resource
+	 *
+	 * @param resource where the storage comes from
+	 */
+	CacheAlignedAllocator(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : resource(resource) {}
+
+	template<typename U>
+	CacheAlignedAllocator(const CacheAlignedAllocator<U>& other) : resource(other.resource) {}
+
+	/**
+	 * Allocates room for count objects starting on a cache line
+	 *
+	 * @param count number of objects to make room for
+	 *
+	 * @return pointer to the (uninitialized) storage
+	 */
+	T* allocate(std::size_t count) {
+		return static_cast<T*>(resource->allocate(count * sizeof(T), CACHE_LINE_SIZE));
+	}
+
+	/**
+	 * Releases storage from allocate
+	 *
+	 * @param ptr storage to release
+	 * @param count number of objects the storage was made for
+	 */
+	void deallocate(T* ptr, std::size_t count) {
+		resource->deallocate(ptr, count * sizeof(T), CACHE_LINE_SIZE);
+	}
+
+	template<typename U>
+	bool operator==(const CacheAlignedAllocator<U>& other) const { return *resource == *other.resource; }
+};
+#endif
@@ -0,0 +1,291 @@
+#include "ChunkedLogProcessor.h"
+
+#include <span>
+
+#include "DataPreProcessor.h"
+#include "LeastSquaresApproximation.h"
+#include "MappedTempParser.h"
+#include "PiecewiseLinearInterpolation.h"
+#include "PipelineArena.h"
+#include "ReportFormatter.h"
+#include "ReportWriter.h"
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Reads the next chunk of whole lines. A last line without '\n' is part
+ * of the last chunk.
+ *
+ * @param chunk text updated with the lines read
+ *
+ * @return false once the log has been read
+ */
+bool ChunkedLogProcessor::ReadChunk(std::string& chunk) {
+	chunk.swap(carry);
+	carry.clear();
+	while (true) {
+		std::size_t oldSize = chunk.size();
+		chunk.resize(oldSize + chunkBytes);
+		input.read(chunk.data() + oldSize, chunkBytes);
+		std::size_t numRead = input.gcount();
+		chunk.resize(oldSize + numRead);
+		bytesRead += numRead;
+		if (numRead == 0) {
+			return !chunk.empty();
+		}
+
+		//The carried text has no '\n', so any line end is in what was just read
+		std::size_t lineEnd = chunk.find_last_of('\n');
+		if (lineEnd != std::string::npos) {
+			carry.assign(chunk, lineEnd + 1);
+			chunk.resize(lineEnd + 1);
+			return true;
+		}
+	}
+}
+
+/**
+ * Counts the readings on the first line of the log, which decides the
+ * number of cores as it does for DataPreProcessor
+ *
+ * @param firstChunk text of the first chunk of the log
+ *
+ * @throws std::invalid_argument on a token that is not a number (same as stod)
+ */
+void ChunkedLogProcessor::CountLogCores(std::string_view firstChunk) {
+	//A blank first line has no readings, so the log has no cores
+	logCores = 0;
+	std::vector<double> lineReadings;
+	MappedTempParser::ForEachReadingIn(firstChunk.substr(0, firstChunk.find('\n')), 0, stepSize, lineReadings,
+		[this](int, const std::vector<double>& temps) { logCores = temps.size(); });
+}
+
+/**
+ * Parses one chunk and formats its interpolations, filling everything in
+ * the chunk but its text and line numbers. Safe to run for several chunks
+ * at once.
+ *
+ * @param chunk chunk to process, with its text, numLines and firstLine set
+ */
+void ChunkedLogProcessor::ProcessChunk(Chunk& chunk) const {
+	//Each worker keeps one arena and reuses it for every chunk it takes
+	static thread_local PipelineArena arena;
+	{
+		DataPreProcessor processedData = [this, &chunk] {
+			PipelineStats::StageTimer timer(stats, PipelineStage::Parse);
+			//Blank or short lines are zero-filled to the cores of the log, as in the in-memory pipeline
+			return DataPreProcessor(chunk.text, stepSize, &arena, static_cast<int>(chunk.firstLine) * stepSize, logCores);
+		}();
+		int numCores = processedData.GetNumCores();
+		std::span<const int> times = processedData.GetTimes();
+
+		PiecewiseLinearInterpolation interpolationCalculator;
+		InterpolationTable interpolations(&arena);
+		{
+			PipelineStats::StageTimer timer(stats, PipelineStage::Interpolate);
+			interpolationCalculator.Calculate(interpolations, processedData);
+		}
+
+		{
+			PipelineStats::StageTimer timer(stats, PipelineStage::Fit);
+			chunk.coreSums.assign(numCores, LeastSquaresAccumulator());
+			for (int core = 0; core < numCores; core++) {
+				std::span<const double> temps = processedData.GetCoreReadings(core);
+				for (std::size_t i = 0; i < times.size(); i++) {
+					chunk.coreSums[core].Add(times[i], temps[i]);
+				}
+			}
+			if (writeCorrelation) {
+				chunk.correlation.Calculate(processedData);
+			}
+		}
+
+		PipelineStats::StageTimer timer(stats, PipelineStage::Format);
+		chunk.firstTemps.resize(numCores);
+		chunk.lastTemps.resize(numCores);
+		chunk.coreReports.resize(numCores);
+		for (int core = 0; core < numCores; core++) {
+			std::span<const double> temps = processedData.GetCoreReadings(core);
+			chunk.firstTemps[core] = temps.front();
+			chunk.lastTemps[core] = temps.back();
+
+			//Cleared rather than replaced, so the buffer is only allocated once
+			ReportFormatter& coreReport = chunk.coreReports[core];
+			coreReport.Clear();
+			coreReport.Reserve(times.size());
+			interpolationCalculator.AppendTo(coreReport, interpolations.GetSlopes(core), interpolations.GetIntercepts(core),
+				times, chunk.firstLine);
+		}
+	}
+	arena.Reset();
+}
+
+/**
+ * Appends a processed chunk to the reports, after the interpolation across
+ * the seam with the chunk before it, and merges its least squares sums
+ * and correlation
+ *
+ * @param chunk the chunk following the last one written
+ */
+void ChunkedLogProcessor::WriteChunk(const Chunk& chunk) {
+	PipelineStats::StageTimer timer(stats, PipelineStage::Write);
+	int numCores = chunk.coreReports.size();
+	if (coreOutputs.empty()) {
+		for (int core = 0; core < numCores; core++) {
+			coreOutputs.emplace_back(coreReportName(inputFileName, core));
+		}
+		coreSums.resize(numCores);
+	}
+
+	PiecewiseLinearInterpolation interpolationCalculator;
+	int seamStart = static_cast<int>(chunk.firstLine - 1) * stepSize;
+	int seamEnd = static_cast<int>(chunk.firstLine) * stepSize;
+	std::size_t numBytes = 0;
+	for (int core = 0; core < numCores && core < coreOutputs.size(); core++) {
+		if (chunk.firstLine > 0) {
+			SlopeAndIntercept seam = interpolationCalculator.CalculateSegment(seamStart, seamEnd, lastTemps[core], chunk.firstTemps[core]);
+			ReportFormatter seamLine;
+			seamLine.AppendInterpolation(seamStart, seamEnd, chunk.firstLine - 1, seam.second, seam.first);
+			std::string seamText = seamLine.Take();
+			coreOutputs[core] << seamText;
+			numBytes += seamText.size();
+		}
+		std::string_view coreReport = chunk.coreReports[core].View();
+		coreOutputs[core] << coreReport;
+		numBytes += coreReport.size();
+		coreSums[core].Merge(chunk.coreSums[core]);
+	}
+	if (writeCorrelation) {
+		correlation.Merge(chunk.correlation);
+	}
+
+	//Every line but the very first ends an interpolation
+	numSegments += (chunk.firstLine > 0 ? chunk.numLines : chunk.numLines - 1) * coreOutputs.size();
+	numLines += chunk.numLines;
+	lastTemps = chunk.lastTemps;
+	if (stats != nullptr) {
+		stats->AddBytesWritten(numBytes);
+	}
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Sets up the processing of one log
+ *
+ * @param inputFileName log to process; the reports are named after it
+ * @param chunkBytes bytes read for each chunk
+ * @param pool workers processing the chunks of a wave, nullptr to process them one at a time
+ * @param stats where stage timings go, nullptr for none
+ * @param writeCorrelation also write the core-to-core covariance and correlation
+ * @param step_size time-step in seconds
+ */
+ChunkedLogProcessor::ChunkedLogProcessor(const std::string& inputFileName, std::size_t chunkBytes, ThreadPool* pool,
+	PipelineStats* stats, bool writeCorrelation, int step_size)
+	: inputFileName(inputFileName), chunkBytes(chunkBytes > 0 ? chunkBytes : 1), stepSize(step_size), pool(pool), stats(stats),
+	writeCorrelation(writeCorrelation) {
+}
+
+/**
+ * Processes the whole log and writes the reports
+ *
+ * @return false if the log could not be opened or a report could not be written
+ *
+ * @throws std::invalid_argument on a token that is not a number (same as stod)
+ */
+bool ChunkedLogProcessor::Run() {
+	input.open(inputFileName, std::ios::binary);
+	if (!input.is_open()) {
+		return false;
+	}
+	bool written = true;
+
+	//One chunk per worker is in memory at a time
+	std::vector<Chunk> wave(pool != nullptr ? pool->GetNumThreads() : 1);
+	while (true) {
+		std::size_t numChunks = 0;
+		while (numChunks < wave.size() && ReadChunk(wave[numChunks].text)) {
+			numChunks++;
+		}
+		if (numChunks == 0) {
+			break;
+		}
+		if (logCores < 0) {
+			CountLogCores(wave[0].text);
+		}
+
+		//Count the lines of every chunk, then number them from the lines before
+		for (std::size_t i = 0; i < numChunks; i++) {
+			Chunk& chunk = wave[i];
+			if (pool != nullptr) {
+				pool->Submit([&chunk] { chunk.numLines = MappedTempParser::CountLines(chunk.text); });
+			}
+			else {
+				chunk.numLines = MappedTempParser::CountLines(chunk.text);
+			}
+		}
+		if (pool != nullptr) {
+			pool->Wait();
+		}
+		std::size_t firstLine = numLines;
+		for (std::size_t i = 0; i < numChunks; i++) {
+			wave[i].firstLine = firstLine;
+			firstLine += wave[i].numLines;
+		}
+
+		for (std::size_t i = 0; i < numChunks; i++) {
+			Chunk& chunk = wave[i];
+			if (pool != nullptr) {
+				pool->Submit([this, &chunk] { ProcessChunk(chunk); });
+			}
+			else {
+				ProcessChunk(chunk);
+			}
+		}
+		if (pool != nullptr) {
+			pool->Wait();
+		}
+
+		for (std::size_t i = 0; i < numChunks; i++) {
+			WriteChunk(wave[i]);
+		}
+	}
+
+	//The merged sums hold every reading, so this is the fit of the whole log
+	if (numLines > 0) {
+		PipelineStats::StageTimer timer(stats, PipelineStage::Fit);
+		LeastSquaresApproximation leastSquareCalculator;
+		int limits[] = { 0, static_cast<int>(numLines - 1) * stepSize };
+		for (int core = 0; core < coreOutputs.size(); core++) {
+			ReportFormatter coreReport;
+			leastSquareCalculator.AppendTo(coreReport, leastSquareCalculator.Calculate(coreSums[core]), limits);
+			std::string fitLine = coreReport.Take();
+			coreOutputs[core] << fitLine;
+			if (stats != nullptr) {
+				stats->AddBytesWritten(fitLine.size());
+			}
+		}
+	}
+	if (writeCorrelation && numLines > 0) {
+		ReportFormatter correlationReport;
+		correlation.Flush();
+		correlation.AppendTo(correlationReport);
+		std::ofstream correlationOutput(correlationReportName(inputFileName));
+		correlationOutput << correlationReport.View();
+		correlationOutput.close();
+		written = written && correlationOutput;
+		if (stats != nullptr) {
+			stats->AddBytesWritten(correlationReport.View().size());
+		}
+	}
+
+	//A failed open, write or close leaves the stream failed, so checking after close catches all three
+	for (std::ofstream& coreOutput : coreOutputs) {
+		coreOutput.close();
+		written = written && coreOutput;
+	}
+	if (stats != nullptr) {
+		stats->AddFile(bytesRead, GetNumSamples(), numSegments);
+	}
+	return written;
+}
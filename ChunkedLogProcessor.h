@@ -0,0 +1,146 @@
+/**
+ * The Chunked Log Processor writes the same reports as the in-memory
+ * pipeline for logs too large to hold in memory. The log is read a chunk
+ * at a time, each chunk ending on a line boundary, and a wave of chunks (one
+ * per worker) is parsed, interpolated and formatted in parallel:
+ *
+ *   1. the lines of every chunk in the wave are counted, and the running
+ *      count (the lines of every chunk before it) gives each chunk the time
+ *      and interpolation number of its first line,
+ *   2. every chunk is processed on its own, keeping the least squares sums of
+ *      each core and its first and last readings,
+ *   3. the chunks are appended to the reports in order, with the
+ *      interpolation across each seam (last reading of one chunk to the first
+ *      of the next) written between them, and their sums are merged.
+ *
+ * Once the last wave is written the merged sums give the global least
+ * squares line. The core-to-core correlation, when asked for, is merged
+ * from the chunks the same way. Memory use depends on the chunk size and the number of
+ * workers, not on the size of the log.
+ */
+#ifndef CHUNKED_LOG_PROCESSOR_H_INCLUDED
+#define CHUNKED_LOG_PROCESSOR_H_INCLUDED
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CoreCorrelation.h"
+#include "LeastSquaresAccumulator.h"
+#include "PipelineStats.h"
+#include "ReportFormatter.h"
+#include "ThreadPool.h"
+
+class ChunkedLogProcessor
+{
+private:
+
+	/**
+	 * One piece of the log and everything worked out from it
+	 */
+	struct Chunk
+	{
+		std::string text = {}; //!< Whole lines of the log
+		std::size_t numLines = 0; //!< Lines in text
+		std::size_t firstLine = 0; //!< Number of the first line within the whole log
+		std::vector<double> firstTemps = {}; //!< Readings of the first line, one per core
+		std::vector<double> lastTemps = {}; //!< Readings of the last line, one per core
+		std::vector<ReportFormatter> coreReports = {}; //!< Interpolation lines of every core, reused from wave to wave
+		std::vector<LeastSquaresAccumulator> coreSums = {}; //!< Least squares sums of every core
+		CoreCorrelation correlation = {}; //!< Co-moments of every pair of cores, when asked for
+	};
+
+	std::string inputFileName; //!< Log being processed
+	std::size_t chunkBytes; //!< Bytes read for each chunk (a chunk grows to the end of its last line)
+	int stepSize; //!< Time-step in seconds
+	ThreadPool* pool; //!< Workers processing the chunks of a wave, nullptr to process them one at a time
+	PipelineStats* stats; //!< Where stage timings go, nullptr for none
+	bool writeCorrelation; //!< Whether <base>-correlation.txt is written too
+
+	std::ifstream input; //!< The log
+	std::string carry = {}; //!< Start of a line cut off at the end of the last chunk read
+	int logCores = -1; //!< Readings on the first line of the log, which every chunk keeps to (-1 until it is read)
+	std::vector<std::ofstream> coreOutputs = {}; //!< Report of every core, opened with the first chunk
+	std::vector<LeastSquaresAccumulator> coreSums = {}; //!< Least squares sums of every core over the chunks written so far
+	CoreCorrelation correlation = {}; //!< Co-moments of every pair of cores over the chunks written so far
+	std::vector<double> lastTemps = {}; //!< Readings of the last line written so far
+	std::size_t numLines = 0; //!< Lines written so far
+	std::size_t bytesRead = 0; //!< Bytes of the log read so far
+	std::size_t numSegments = 0; //!< Interpolations written so far over all cores
+
+	/**
+	 * Reads the next chunk of whole lines. A last line without '\n' is part
+	 * of the last chunk.
+	 *
+	 * @param chunk text updated with the lines read
+	 *
+	 * @return false once the log has been read
+	 */
+	bool ReadChunk(std::string& chunk);
+
+	/**
+	 * Counts the readings on the first line of the log, which decides the
+	 * number of cores as it does for DataPreProcessor
+	 *
+	 * @param firstChunk text of the first chunk of the log
+	 *
+	 * @throws std::invalid_argument on a token that is not a number (same as stod)
+	 */
+	void CountLogCores(std::string_view firstChunk);
+
+	/**
+	 * Parses one chunk and formats its interpolations, filling everything in
+	 * the chunk but its text and line numbers. Safe to run for several chunks
+	 * at once.
+	 *
+	 * @param chunk chunk to process, with its text, numLines and firstLine set
+	 */
+	void ProcessChunk(Chunk& chunk) const;
+
+	/**
+	 * Appends a processed chunk to the reports, after the interpolation across
+	 * the seam with the chunk before it, and merges its least squares sums
+	 * and correlation
+	 *
+	 * @param chunk the chunk following the last one written
+	 */
+	void WriteChunk(const Chunk& chunk);
+
+public:
+
+	/**
+	 * Sets up the processing of one log
+	 *
+	 * @param inputFileName log to process; the reports are named after it
+	 * @param chunkBytes bytes read for each chunk
+	 * @param pool workers processing the chunks of a wave, nullptr to process them one at a time
+	 * @param stats where stage timings go, nullptr for none
+	 * @param writeCorrelation also write the core-to-core covariance and correlation
+	 * @param step_size time-step in seconds
+	 */
+	ChunkedLogProcessor(const std::string& inputFileName, std::size_t chunkBytes, ThreadPool* pool,
+		PipelineStats* stats = nullptr, bool writeCorrelation = false, int step_size = 30);
+
+	/**
+	 * Processes the whole log and writes the reports
+	 *
+	 * @return false if the log could not be opened or a report could not be written
+	 *
+	 * @throws std::invalid_argument on a token that is not a number (same as stod)
+	 */
+	bool Run();
+
+	/**
+	 * Reports if the log was opened, telling the two failures of Run apart
+	 *
+	 * @return false if the log could not be opened
+	 */
+	bool IsOpen() const { return input.is_open(); }
+
+	std::size_t GetBytesRead() const { return bytesRead; }
+	std::size_t GetNumSamples() const { return numLines * coreSums.size(); }
+	std::size_t GetNumSegments() const { return numSegments; }
+};
+#endif
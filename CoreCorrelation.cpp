@@ -0,0 +1,345 @@
+#include "CoreCorrelation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Adds the products of a run of shifted rows to one tile of the
+ * co-moment matrix, keeping only the upper triangle
+ *
+ * @param comoments co-moment matrix, numCores x numCores row-major
+ * @param rows shifted readings, one row of numCores per reading
+ * @param numRows rows to add
+ * @param numCores cores in every row
+ * @param core0 first core of the tile's rows
+ * @param core0End core past the tile's rows
+ * @param core1 first core of the tile's columns
+ * @param core1End core past the tile's columns
+ */
+void CoreCorrelation::TileKernel(double* comoments, const double* rows, std::size_t numRows, int numCores,
+	int core0, int core0End, int core1, int core1End) {
+	for (std::size_t r = 0; r < numRows; r++) {
+		const double* __restrict row = rows + r * numCores;
+		for (int i = core0; i < core0End; i++) {
+			double deviation = row[i];
+			double* __restrict tileRow = comoments + static_cast<std::size_t>(i) * numCores;
+			for (int j = std::max(core1, i); j < core1End; j++) {
+				tileRow[j] += deviation * row[j];
+			}
+		}
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * Same as TileKernel, using AVX2 to work on 4 cores at a time. Only
+ * called when the CPU supports AVX2.
+ */
+__attribute__((target("avx2")))
+void CoreCorrelation::TileKernelAvx2(double* comoments, const double* rows, std::size_t numRows, int numCores,
+	int core0, int core0End, int core1, int core1End) {
+	for (std::size_t r = 0; r < numRows; r++) {
+		const double* row = rows + r * numCores;
+		for (int i = core0; i < core0End; i++) {
+			double deviation = row[i];
+			__m256d deviations = _mm256_set1_pd(deviation);
+			double* tileRow = comoments + static_cast<std::size_t>(i) * numCores;
+			int j = std::max(core1, i);
+			for (; j + 4 <= core1End; j += 4) {
+				//Multiply and add stay separate (no FMA) to match the scalar rounding
+				__m256d products = _mm256_mul_pd(deviations, _mm256_loadu_pd(row + j));
+				_mm256_storeu_pd(tileRow + j, _mm256_add_pd(_mm256_loadu_pd(tileRow + j), products));
+			}
+			for (; j < core1End; j++) {
+				tileRow[j] += deviation * row[j];
+			}
+		}
+	}
+}
+#else
+void CoreCorrelation::TileKernelAvx2(double* comoments, const double* rows, std::size_t numRows, int numCores,
+	int core0, int core0End, int core1, int core1End) {
+	TileKernel(comoments, rows, numRows, numCores, core0, core0End, core1, core1End);
+}
+#endif
+
+/**
+ * Merges the mean and co-moments of a group of readings into the
+ * running totals
+ *
+ * @param otherCount readings in the group
+ * @param otherMeans mean of every core over the group
+ * @param otherComoments co-moments of the group (upper triangle)
+ */
+void CoreCorrelation::MergeMoments(long long otherCount, const std::vector<double>& otherMeans, const std::vector<double>& otherComoments) {
+	if (otherCount == 0) {
+		return;
+	}
+	if (count == 0) {
+		count = otherCount;
+		means = otherMeans;
+		comoments = otherComoments;
+		return;
+	}
+
+	long long total = count + otherCount;
+	double pairWeight = static_cast<double>(count) * otherCount / total;
+	double otherWeight = static_cast<double>(otherCount) / total;
+	std::vector<double> deltas(numCores);
+	for (int core = 0; core < numCores; core++) {
+		deltas[core] = otherMeans[core] - means[core];
+	}
+	for (int i = 0; i < numCores; i++) {
+		double scaledDelta = deltas[i] * pairWeight;
+		double* row = comoments.data() + static_cast<std::size_t>(i) * numCores;
+		const double* otherRow = otherComoments.data() + static_cast<std::size_t>(i) * numCores;
+		for (int j = i; j < numCores; j++) {
+			row[j] += otherRow[j] + scaledDelta * deltas[j];
+		}
+	}
+	for (int core = 0; core < numCores; core++) {
+		means[core] += deltas[core] * otherWeight;
+	}
+	count = total;
+}
+
+/**
+ * Folds the rows waiting in block into the running totals
+ */
+void CoreCorrelation::FoldBlock() {
+	if (numBlockRows == 0) {
+		return;
+	}
+
+	//Shift every row by the first, then sum the shifted readings
+	std::copy(block.begin(), block.begin() + numCores, blockShifts.begin());
+	std::fill(blockSums.begin(), blockSums.end(), 0.0);
+	for (std::size_t r = 0; r < numBlockRows; r++) {
+		double* __restrict row = block.data() + r * numCores;
+		const double* __restrict shifts = blockShifts.data();
+		double* __restrict sums = blockSums.data();
+		for (int core = 0; core < numCores; core++) {
+			row[core] -= shifts[core];
+			sums[core] += row[core];
+		}
+	}
+
+	//Sums of products one tile at a time, the diagonal tiles holding only their upper half
+	std::fill(blockComoments.begin(), blockComoments.end(), 0.0);
+	for (int core0 = 0; core0 < numCores; core0 += TILE_CORES) {
+		int core0End = std::min(core0 + TILE_CORES, numCores);
+		for (int core1 = core0; core1 < numCores; core1 += TILE_CORES) {
+			int core1End = std::min(core1 + TILE_CORES, numCores);
+			if (useAvx2) {
+				TileKernelAvx2(blockComoments.data(), block.data(), numBlockRows, numCores, core0, core0End, core1, core1End);
+			}
+			else {
+				TileKernel(blockComoments.data(), block.data(), numBlockRows, numCores, core0, core0End, core1, core1End);
+			}
+		}
+	}
+
+	//Products of the shifted readings less the part owed to their means
+	double numRows = static_cast<double>(numBlockRows);
+	for (int i = 0; i < numCores; i++) {
+		double scaledSum = blockSums[i] / numRows;
+		double* row = blockComoments.data() + static_cast<std::size_t>(i) * numCores;
+		for (int j = i; j < numCores; j++) {
+			row[j] -= scaledSum * blockSums[j];
+		}
+		blockShifts[i] += scaledSum;
+	}
+
+	long long blockCount = numBlockRows;
+	numBlockRows = 0;
+	MergeMoments(blockCount, blockShifts, blockComoments);
+}
+
+/**
+ * Folds a range of readings taken straight from the core columns
+ *
+ * @param data provides the temps of every core
+ * @param first index of the first reading
+ * @param last index past the last reading
+ */
+void CoreCorrelation::AddReadings(const DataPreProcessor& data, std::size_t first, std::size_t last) {
+	while (first < last) {
+		std::size_t numRows = std::min(BLOCK_ROWS - numBlockRows, last - first);
+		for (int core = 0; core < numCores; core++) {
+			const double* temps = data.GetCoreReadings(core).data() + first;
+			double* slot = block.data() + numBlockRows * numCores + core;
+			for (std::size_t r = 0; r < numRows; r++) {
+				slot[r * numCores] = temps[r];
+			}
+		}
+		numBlockRows += numRows;
+		first += numRows;
+		if (numBlockRows == BLOCK_ROWS) {
+			FoldBlock();
+		}
+	}
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Sets up an empty accumulator
+ *
+ * @param numCores number of cores in every reading (0 to take it from the first Merge)
+ */
+CoreCorrelation::CoreCorrelation(int numCores) : numCores(numCores > 0 ? numCores : 0) {
+	std::size_t cores = this->numCores;
+	means.resize(cores);
+	comoments.resize(cores * cores);
+	block.resize(BLOCK_ROWS * cores);
+	blockShifts.resize(cores);
+	blockSums.resize(cores);
+	blockComoments.resize(cores * cores);
+#if defined(__x86_64__) || defined(__i386__)
+	useAvx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+/**
+ * Works out the covariance and correlation of every pair of cores in one
+ * pass over the readings, replacing anything folded in before. With a
+ * pool the readings are split into one range per worker and the ranges
+ * are merged in order.
+ *
+ * @param data provides the temps of every core
+ * @param pool workers sharing the readings, nullptr to use this thread only
+ */
+void CoreCorrelation::Calculate(const DataPreProcessor& data, ThreadPool* pool) {
+	*this = CoreCorrelation(data.GetNumCores());
+	std::size_t numReadings = data.GetTimes().size();
+	std::size_t numBlocks = (numReadings + BLOCK_ROWS - 1) / BLOCK_ROWS;
+	std::size_t numParts = pool != nullptr ? std::min<std::size_t>(pool->GetNumThreads(), numBlocks) : 1;
+	if (numParts <= 1) {
+		AddReadings(data, 0, numReadings);
+		Flush();
+		return;
+	}
+
+	//Ranges start on a block boundary so every part folds whole blocks
+	std::size_t partRows = ((numBlocks + numParts - 1) / numParts) * BLOCK_ROWS;
+	std::vector<CoreCorrelation> parts(numParts, CoreCorrelation(numCores));
+	for (std::size_t part = 0; part < numParts; part++) {
+		pool->Submit([&data, &parts, part, partRows, numReadings] {
+			std::size_t first = std::min(part * partRows, numReadings);
+			parts[part].AddReadings(data, first, std::min(first + partRows, numReadings));
+			parts[part].Flush();
+		});
+	}
+	pool->Wait();
+	for (const CoreCorrelation& part : parts) {
+		Merge(part);
+	}
+}
+
+/**
+ * Folds in one reading of every core
+ *
+ * @param temps temperature of every core
+ *
+ * @pre temps.size() == GetNumCores()
+ */
+void CoreCorrelation::AddReading(std::span<const double> temps) {
+	std::copy(temps.begin(), temps.begin() + numCores, block.begin() + numBlockRows * numCores);
+	numBlockRows++;
+	if (numBlockRows == BLOCK_ROWS) {
+		FoldBlock();
+	}
+}
+
+/**
+ * Folds in every reading of another accumulator, as if they had been
+ * added to this one after its own
+ *
+ * @param other accumulator over the same cores (or over any cores if this one is empty)
+ */
+void CoreCorrelation::Merge(const CoreCorrelation& other) {
+	if (numCores == 0 && count == 0) {
+		*this = CoreCorrelation(other.numCores);
+	}
+	if (other.numCores != numCores) {
+		return;
+	}
+
+	//Readings waiting in this block come before the other's
+	Flush();
+	MergeMoments(other.count, other.means, other.comoments);
+	for (std::size_t r = 0; r < other.numBlockRows; r++) {
+		AddReading(std::span<const double>(other.block).subspan(r * numCores, numCores));
+	}
+}
+
+/**
+ * Folds in the readings still waiting in the current block, so the
+ * results cover every reading added
+ */
+void CoreCorrelation::Flush() {
+	FoldBlock();
+}
+
+/**
+ * Fetches the sample covariance of two cores
+ *
+ * @param core0 number of the first core
+ * @param core1 number of the second core
+ *
+ * @return the covariance (the variance when core0 == core1, nan for fewer than 2 readings)
+ *
+ * @pre Flush was called after the last reading was added
+ */
+double CoreCorrelation::GetCovariance(int core0, int core1) const {
+	if (count < 2) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	std::size_t row = std::min(core0, core1);
+	std::size_t column = std::max(core0, core1);
+	return comoments[row * numCores + column] / (count - 1);
+}
+
+/**
+ * Fetches the Pearson correlation of two cores
+ *
+ * @param core0 number of the first core
+ * @param core1 number of the second core
+ *
+ * @return the correlation, between -1 and 1 (nan if either core never changes)
+ *
+ * @pre Flush was called after the last reading was added
+ */
+double CoreCorrelation::GetCorrelation(int core0, int core1) const {
+	std::size_t row = std::min(core0, core1);
+	std::size_t column = std::max(core0, core1);
+	double spread = std::sqrt(comoments[row * numCores + row] * comoments[column * numCores + column]);
+	if (count < 2 || !(spread > 0.0)) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	//Rounding can push a near perfect correlation just past 1
+	return std::clamp(comoments[row * numCores + column] / spread, -1.0, 1.0);
+}
+
+/**
+ * Appends one line per pair of cores, variances included, to a report
+ *
+ * @param report where the lines go
+ *
+ * @pre Flush was called after the last reading was added
+ */
+void CoreCorrelation::AppendTo(ReportFormatter& report) const {
+	report.Reserve(static_cast<std::size_t>(numCores) * (numCores + 1) / 2);
+	for (int core0 = 0; core0 < numCores; core0++) {
+		for (int core1 = core0; core1 < numCores; core1++) {
+			report.AppendCorrelation(core0, core1, GetCovariance(core0, core1), GetCorrelation(core0, core1));
+		}
+	}
+}
@@ -0,0 +1,177 @@
+/**
+ * The Core Correlation class works out the N x N covariance and Pearson
+ * correlation of every pair of cores, showing which cores heat up together.
+ *
+ * Readings are folded in a block of rows at a time (one row is one reading
+ * of every core). Each block is shifted by its first row, so the sums stay
+ * small and a core that never changes has exactly zero variance, and its
+ * co-moments (sums of products of deviations) are accumulated a tile of the
+ * matrix at a time, so the tile and the block stay in cache while every row
+ * of the block runs through a SIMD kernel (AVX2 where the CPU has it). The
+ * block is then merged into the running totals with the pairwise update of
+ * Chan et al.:
+ *
+ *   n = nA + nB, delta = meanB - meanA
+ *   M = MA + MB + delta * delta^T * nA * nB / n
+ *
+ * The same update merges two whole accumulators, so a long history can be
+ * split over workers or chunks and the parts merged in order. Memory use
+ * depends on the number of cores, not on the number of readings.
+ */
+#ifndef CORE_CORRELATION_H_INCLUDED
+#define CORE_CORRELATION_H_INCLUDED
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "DataPreProcessor.h"
+#include "ReportFormatter.h"
+#include "ThreadPool.h"
+
+class CoreCorrelation
+{
+private:
+
+	static constexpr std::size_t BLOCK_ROWS = 256; //!< Readings folded in at a time (256 KB of rows for 128 cores, which stays in L2)
+	static constexpr int TILE_CORES = 32; //!< Cores along each side of a tile of the co-moment matrix (8 KB, which stays in L1)
+
+	int numCores = 0; //!< Number of cores in every reading
+	long long count = 0; //!< Readings folded in so far
+	std::vector<double> means = {}; //!< Mean of every core over the readings folded in
+	std::vector<double> comoments = {}; //!< Co-moments of every pair of cores, row-major; only the upper triangle (core0 <= core1) is kept
+
+	std::vector<double> block = {}; //!< Readings not folded in yet, one row of numCores per reading
+	std::size_t numBlockRows = 0; //!< Rows of block in use
+	std::vector<double> blockShifts = {}; //!< Scratch: first row of the block being folded in, then the means of the block
+	std::vector<double> blockSums = {}; //!< Scratch: sums of the shifted readings of the block being folded in
+	std::vector<double> blockComoments = {}; //!< Scratch: co-moments of the block being folded in
+	bool useAvx2 = false; //!< Whether the tile kernel runs with AVX2
+
+	/**
+	 * Adds the products of a run of shifted rows to one tile of the
+	 * co-moment matrix, keeping only the upper triangle
+	 *
+	 * @param comoments co-moment matrix, numCores x numCores row-major
+	 * @param rows shifted readings, one row of numCores per reading
+	 * @param numRows rows to add
+	 * @param numCores cores in every row
+	 * @param core0 first core of the tile's rows
+	 * @param core0End core past the tile's rows
+	 * @param core1 first core of the tile's columns
+	 * @param core1End core past the tile's columns
+	 */
+	static void TileKernel(double* comoments, const double* rows, std::size_t numRows, int numCores,
+		int core0, int core0End, int core1, int core1End);
+
+	/**
+	 * Same as TileKernel, using AVX2 to work on 4 cores at a time. Only
+	 * called when the CPU supports AVX2.
+	 */
+	static void TileKernelAvx2(double* comoments, const double* rows, std::size_t numRows, int numCores,
+		int core0, int core0End, int core1, int core1End);
+
+	/**
+	 * Merges the mean and co-moments of a group of readings into the
+	 * running totals
+	 *
+	 * @param otherCount readings in the group
+	 * @param otherMeans mean of every core over the group
+	 * @param otherComoments co-moments of the group (upper triangle)
+	 */
+	void MergeMoments(long long otherCount, const std::vector<double>& otherMeans, const std::vector<double>& otherComoments);
+
+	/**
+	 * Folds the rows waiting in block into the running totals
+	 */
+	void FoldBlock();
+
+	/**
+	 * Folds a range of readings taken straight from the core columns
+	 *
+	 * @param data provides the temps of every core
+	 * @param first index of the first reading
+	 * @param last index past the last reading
+	 */
+	void AddReadings(const DataPreProcessor& data, std::size_t first, std::size_t last);
+
+public:
+
+	/**
+	 * Sets up an empty accumulator
+	 *
+	 * @param numCores number of cores in every reading (0 to take it from the first Merge)
+	 */
+	CoreCorrelation(int numCores = 0);
+
+	/**
+	 * Works out the covariance and correlation of every pair of cores in one
+	 * pass over the readings, replacing anything folded in before. With a
+	 * pool the readings are split into one range per worker and the ranges
+	 * are merged in order.
+	 *
+	 * @param data provides the temps of every core
+	 * @param pool workers sharing the readings, nullptr to use this thread only
+	 */
+	void Calculate(const DataPreProcessor& data, ThreadPool* pool = nullptr);
+
+	/**
+	 * Folds in one reading of every core
+	 *
+	 * @param temps temperature of every core
+	 *
+	 * @pre temps.size() == GetNumCores()
+	 */
+	void AddReading(std::span<const double> temps);
+
+	/**
+	 * Folds in every reading of another accumulator, as if they had been
+	 * added to this one after its own
+	 *
+	 * @param other accumulator over the same cores (or over any cores if this one is empty)
+	 */
+	void Merge(const CoreCorrelation& other);
+
+	/**
+	 * Folds in the readings still waiting in the current block, so the
+	 * results cover every reading added
+	 */
+	void Flush();
+
+	/**
+	 * Fetches the sample covariance of two cores
+	 *
+	 * @param core0 number of the first core
+	 * @param core1 number of the second core
+	 *
+	 * @return the covariance (the variance when core0 == core1, nan for fewer than 2 readings)
+	 *
+	 * @pre Flush was called after the last reading was added
+	 */
+	double GetCovariance(int core0, int core1) const;
+
+	/**
+	 * Fetches the Pearson correlation of two cores
+	 *
+	 * @param core0 number of the first core
+	 * @param core1 number of the second core
+	 *
+	 * @return the correlation, between -1 and 1 (nan if either core never changes)
+	 *
+	 * @pre Flush was called after the last reading was added
+	 */
+	double GetCorrelation(int core0, int core1) const;
+
+	/**
+	 * Appends one line per pair of cores, variances included, to a report
+	 *
+	 * @param report where the lines go
+	 *
+	 * @pre Flush was called after the last reading was added
+	 */
+	void AppendTo(ReportFormatter& report) const;
+
+	int GetNumCores() const { return numCores; }
+	long long GetCount() const { return count + numBlockRows; }
+};
+#endif
@@ -1,23 +1,144 @@
 #include "DataPreProcessor.h"
 
+#include "MappedTempParser.h"
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Transposes the readings into the time and core columns
+ *
+ * @tparam CoreTempReadingContainer container of pair(int, vector of doubles)
+ *
+ * @param readings is input container
+ */
+template<typename CoreTempReadingContainer>
+void DataPreProcessor::Load(const CoreTempReadingContainer& readings) {
+	std::size_t numReadings = readings.size();
+	if (numReadings == 0) {
+		return;
+	}
+
+	//Pad each column so the next one starts on a new cache line
+	const std::size_t perLine = CACHE_LINE_SIZE / sizeof(double);
+	numCores = readings[0].second.size();
+	columnStride = (numReadings + perLine - 1) / perLine * perLine;
+
+	timeReadings.resize(numReadings);
+	coreReadings.resize(columnStride * numCores);
+
+	for (std::size_t i = 0; i < numReadings; i++) {
+		timeReadings[i] = readings[i].first;
+		const auto& temps = readings[i].second;
+
+		//Short rows leave the missing cores at 0
+		std::size_t coresInRow = temps.size() < numCores ? temps.size() : numCores;
+		for (std::size_t core = 0; core < coresInRow; core++) {
+			coreReadings[core * columnStride + i] = temps[core];
+		}
+	}
+}
+
+//--------------------- Public Functions -----------------------//
+
 /**
  * Construct a pre-processor object that can be used to access data in easy to use format
  *
  * @param readings is input container (vector of pair(int,vector<double>))
+ * @param resource where the columns are allocated (i.e. a PipelineArena)
+ *
+ * @pre every vector<double> has the same size as the first one (one reading per core)
+ */
+DataPreProcessor::DataPreProcessor(const std::vector<CoreTempReading>& readings, std::pmr::memory_resource* resource)
+	: timeReadings(resource), coreReadings(resource) {
+	Load(readings);
+}
+
+/**
+ * Construct a pre-processor object from readings that live in a memory resource
+ *
+ * @param readings is input container (vector of pair(int,vector<double>))
+ * @param resource where the columns are allocated (i.e. a PipelineArena)
  *
- * @pre vector<double> size = 4 (4 cores read)
+ * @pre every vector<double> has the same size as the first one (one reading per core)
  */
-DataPreProcessor::DataPreProcessor(const std::vector<CoreTempReading>& readings) {
-	int numReadings = readings.size();
-	std::vector<double> temps;
-	for (int i = 0; i < numReadings; i++) {
-		timeReadings.push_back(readings[i].first);
-		temps = readings[i].second;
-
-		readingsCore0.push_back(temps[0]);
-		readingsCore1.push_back(temps[1]);
-		readingsCore2.push_back(temps[2]);
-		readingsCore3.push_back(temps[3]);
+DataPreProcessor::DataPreProcessor(const std::pmr::vector<ArenaCoreTempReading>& readings, std::pmr::memory_resource* resource)
+	: timeReadings(resource), coreReadings(resource) {
+	Load(readings);
+}
+
+/**
+ * Construct a pre-processor object by parsing a log straight into the
+ * columns, without building a container of readings first. The lines are
+ * counted up front so every column is allocated once.
+ *
+ * @param logText contents of the log (i.e. MappedTempParser::Contents)
+ * @param step_size time-step in seconds
+ * @param resource where the columns are allocated (i.e. a PipelineArena)
+ * @param firstTime time of the first line (non-zero when logText is a later piece of a log)
+ * @param logCores readings on the first line of the whole log when logText is a later
+ *     piece of it, -1 to take the number of cores from the first line of logText
+ *
+ * @throws std::invalid_argument on a token that is not a number (same as stod)
+ */
+DataPreProcessor::DataPreProcessor(std::string_view logText, int step_size, std::pmr::memory_resource* resource, int firstTime,
+	int logCores)
+	: timeReadings(resource), coreReadings(resource) {
+	std::size_t numReadings = MappedTempParser::CountLines(logText);
+	if (numReadings == 0) {
+		return;
+	}
+
+	const std::size_t perLine = CACHE_LINE_SIZE / sizeof(double);
+	columnStride = (numReadings + perLine - 1) / perLine * perLine;
+	timeReadings.resize(numReadings);
+
+	std::vector<double> lineReadings;
+	std::size_t row = 0;
+	MappedTempParser::ForEachReadingIn(logText, firstTime, step_size, lineReadings,
+		[this, &row, logCores](int time, const std::vector<double>& temps) {
+			//The first line decides the number of cores, as in Load
+			if (row == 0) {
+				numCores = logCores >= 0 ? logCores : temps.size();
+				coreReadings.resize(columnStride * numCores);
+			}
+			timeReadings[row] = time;
+
+			//Short rows leave the missing cores at 0
+			std::size_t coresInRow = temps.size() < numCores ? temps.size() : numCores;
+			for (std::size_t core = 0; core < coresInRow; core++) {
+				coreReadings[core * columnStride + row] = temps[core];
+			}
+			row++;
+		});
+}
+
+/**
+ * Construct a pre-processor object from a binary log. Nothing is parsed:
+ * every core's column is converted from fixed point in one pass, and the
+ * times come from the step in the header.
+ *
+ * @param log a valid binary log (see BinaryLog::IsValid)
+ * @param resource where the columns are allocated (i.e. a PipelineArena)
+ */
+DataPreProcessor::DataPreProcessor(const BinaryLog& log, std::pmr::memory_resource* resource)
+	: timeReadings(resource), coreReadings(resource) {
+	std::size_t numReadings = log.GetNumReadings();
+	if (numReadings == 0) {
+		return;
+	}
+
+	const std::size_t perLine = CACHE_LINE_SIZE / sizeof(double);
+	columnStride = (numReadings + perLine - 1) / perLine * perLine;
+	numCores = log.GetNumCores();
+	timeReadings.resize(numReadings);
+	coreReadings.resize(columnStride * numCores);
+
+	int step_size = log.GetStepSize();
+	for (std::size_t row = 0; row < numReadings; row++) {
+		timeReadings[row] = row * step_size;
+	}
+	for (int core = 0; core < numCores; core++) {
+		log.DecodeCore(core, std::span<double>(coreReadings.data() + core * columnStride, numReadings));
 	}
 }
 
@@ -26,21 +147,11 @@ DataPreProcessor::DataPreProcessor(const std::vector<CoreTempReading>& readings)
  *
  * @param coreNum specifies which core readings to return
  *
- * @return a container of all the temperature readings of the specific core
- * 
- * @pre coreNum >= 0 && coreNum < 4
+ * @return a view of all the temperature readings of the specific core (empty if coreNum is out of range)
  */
-const std::vector<double>& DataPreProcessor::GetCoreReadings(int coreNum) const{
-	switch(coreNum) {
-		case 0:
-			return readingsCore0;
-		case 1:
-			return readingsCore1;
-		case 2:
-			return readingsCore2;
-		case 3:
-			return readingsCore3;
-		default:
-			return {}; //Provide empty as default. Empty would indicate error.
+std::span<const double> DataPreProcessor::GetCoreReadings(int coreNum) const {
+	if (coreNum < 0 || coreNum >= numCores) {
+		return {}; //Provide empty as default. Empty would indicate error.
 	}
-}
\ No newline at end of file
+	return std::span<const double>(coreReadings.data() + coreNum * columnStride, timeReadings.size());
+}
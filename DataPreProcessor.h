@@ -1,56 +1,120 @@
 /**
  * The Data Pre-Processor class is designed to take the input data
- * and process it into a more usable form that can be accessed by 
+ * and process it into a more usable form that can be accessed by
  * other classes.
- * 
+ *
+ * Readings are kept as one column per core, all columns laid end to end
+ * in a single cache aligned block. The number of cores comes from the data.
+ *
  * @author Jacob McFadden
  */
 #ifndef DATA_PRE_PROCESSOR_H_INCLUDED
 #define DATA_PRE_PROCESSOR_H_INCLUDED
 
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <string_view>
 #include <vector>
 
+#include "BinaryLog.h"
+#include "CacheAlignedAllocator.h"
+
 using CoreTempReading = std::pair<int, std::vector<double>>;
+using ArenaCoreTempReading = std::pair<int, std::pmr::vector<double>>; //!< CoreTempReading whose storage comes from a memory resource
 
 class DataPreProcessor
 {
-private: 
-	
-	const int NUM_CORES = 4; //!< Expected number of cores we are reading from
+private:
+
+	int numCores = 0; //!< Number of cores we are reading from (taken from the first reading)
+	std::size_t columnStride = 0; //!< Distance between the starts of two core columns, padded to a cache line
 
-	std::vector<int> timeReadings = {}; //!< A list of when the core times were read
-	std::vector<double> readingsCore0 = {};//!< A list of temperature readings for core 0 : ordered by time acquired
-	std::vector<double> readingsCore1 = {}; //!< A list of temperature readings for core 1 : ordered by time acquired
-	std::vector<double> readingsCore2 = {}; //!< A list of temperature readings for core 2 : ordered by time acquired
-	std::vector<double> readingsCore3 = {}; //!< A list of temperature readings for core 3 : ordered by time acquired
+	std::vector<int, CacheAlignedAllocator<int>> timeReadings; //!< A list of when the core times were read
+	std::vector<double, CacheAlignedAllocator<double>> coreReadings; //!< Temperature readings of every core, one column per core : ordered by time acquired
+
+	/**
+	 * Transposes the readings into the time and core columns
+	 *
+	 * @tparam CoreTempReadingContainer container of pair(int, vector of doubles)
+	 *
+	 * @param readings is input container
+	 */
+	template<typename CoreTempReadingContainer>
+	void Load(const CoreTempReadingContainer& readings);
 
 public:
 
 	/**
 	 * Construct a pre-processor object that can be used to access data in easy to use format
-	 * 
+	 *
 	 * @param readings is input container (vector of pair(int,vector<double>))
-	 * 
-	 * @pre vector<double> size = 4 (4 cores read)
+	 * @param resource where the columns are allocated (i.e. a PipelineArena)
+	 *
+	 * @pre every vector<double> has the same size as the first one (one reading per core)
+	 */
+	DataPreProcessor(const std::vector<CoreTempReading>& readings,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	/**
+	 * Construct a pre-processor object from readings that live in a memory resource
+	 *
+	 * @param readings is input container (vector of pair(int,vector<double>))
+	 * @param resource where the columns are allocated (i.e. a PipelineArena)
+	 *
+	 * @pre every vector<double> has the same size as the first one (one reading per core)
 	 */
-	DataPreProcessor(const std::vector<CoreTempReading>& readings);
+	DataPreProcessor(const std::pmr::vector<ArenaCoreTempReading>& readings,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	/**
+	 * Construct a pre-processor object by parsing a log straight into the
+	 * columns, without building a container of readings first. The lines are
+	 * counted up front so every column is allocated once.
+	 *
+	 * @param logText contents of the log (i.e. MappedTempParser::Contents)
+	 * @param step_size time-step in seconds
+	 * @param resource where the columns are allocated (i.e. a PipelineArena)
+	 * @param firstTime time of the first line (non-zero when logText is a later piece of a log)
+	 * @param logCores readings on the first line of the whole log when logText is a later
+	 *     piece of it, -1 to take the number of cores from the first line of logText
+	 *
+	 * @throws std::invalid_argument on a token that is not a number (same as stod)
+	 */
+	DataPreProcessor(std::string_view logText, int step_size = 30,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource(), int firstTime = 0, int logCores = -1);
+
+	/**
+	 * Construct a pre-processor object from a binary log. Nothing is parsed:
+	 * every core's column is converted from fixed point in one pass, and the
+	 * times come from the step in the header.
+	 *
+	 * @param log a valid binary log (see BinaryLog::IsValid)
+	 * @param resource where the columns are allocated (i.e. a PipelineArena)
+	 */
+	DataPreProcessor(const BinaryLog& log, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
 	/**
 	 * Fetches all the readings of one specific core
 	 *
 	 * @param coreNum specifies which core readings to return
-	 * 
-	 * @return a container of all the temperature readings of the specific core
-	 * 
-	 * @pre coreNum >= 0 && coreNum < 4
+	 *
+	 * @return a view of all the temperature readings of the specific core (empty if coreNum is out of range)
 	 */
-	const std::vector<double>& GetCoreReadings(int coreNum) const;
+	std::span<const double> GetCoreReadings(int coreNum) const;
 
 	/**
 	 * Fetches all the times the readings took place at
 	 *
-	 * @return a container of all the times readings occured
+	 * @return a view of all the times readings occured
+	 */
+	std::span<const int> GetTimes() const { return timeReadings; }
+
+	/**
+	 * Fetches how many cores were read
+	 *
+	 * @return the number of core columns
 	 */
-	const std::vector<int>& GetTimes() const { return timeReadings; }
+	int GetNumCores() const { return numCores; }
 };
 #endif
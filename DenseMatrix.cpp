@@ -0,0 +1,127 @@
+#include "DenseMatrix.h"
+
+#include <cmath>
+
+/**
+ * Creates a matrix filled with zeros
+ *
+ * @param rows number of rows
+ * @param cols number of columns
+ */
+DenseMatrix::DenseMatrix(int rows, int cols)
+	: numRows(rows), numCols(cols), values(rows * cols, 0.0) {
+}
+
+/**
+ * Adds AᵀA of the first rows of block to the upper triangle of this matrix.
+ * A is walked row by row, so Aᵀ is never formed.
+ *
+ * @param block row-major matrix A
+ * @param blockRows number of leading rows of block to use
+ *
+ * @pre Rows() == Cols() == block.Cols()
+ */
+void DenseMatrix::AddGramUpper(const DenseMatrix& block, int blockRows) {
+	int n = numCols;
+	//Every row of A adds the outer product a aᵀ; the inner loop is contiguous
+	//in both a and the output row so it vectorizes
+	for (int r = 0; r < blockRows; r++) {
+		const double* a = block.Row(r);
+		for (int i = 0; i < n; i++) {
+			double ai = a[i];
+			double* out = Row(i);
+			for (int j = i; j < n; j++) {
+				out[j] += ai * a[j];
+			}
+		}
+	}
+}
+
+/**
+ * Adds Aᵀy of the first rows of block to rhs
+ *
+ * @param block row-major matrix A
+ * @param blockRows number of leading rows of block to use
+ * @param y right hand values, one per row of block
+ * @param rhs updated with Aᵀy (size block.Cols())
+ */
+void DenseMatrix::AddTransposeProduct(const DenseMatrix& block, int blockRows, std::span<const double> y, std::span<double> rhs) {
+	int n = block.Cols();
+	for (int r = 0; r < blockRows; r++) {
+		const double* a = block.Row(r);
+		double yr = y[r];
+		for (int i = 0; i < n; i++) {
+			rhs[i] += a[i] * yr;
+		}
+	}
+}
+
+/**
+ * Copies the upper triangle into the lower triangle
+ *
+ * @pre Rows() == Cols()
+ */
+void DenseMatrix::MirrorUpper() {
+	for (int i = 0; i < numRows; i++) {
+		for (int j = 0; j < i; j++) {
+			(*this)(i, j) = (*this)(j, i);
+		}
+	}
+}
+
+/**
+ * Replaces the lower triangle with L from A = LLᵀ. Only the lower
+ * triangle (and diagonal) of this matrix is read.
+ *
+ * @return false if the matrix is not symmetric positive-definite
+ *
+ * @pre Rows() == Cols()
+ */
+bool DenseMatrix::CholeskyFactor() {
+	for (int j = 0; j < numRows; j++) {
+		double diagonal = (*this)(j, j);
+		for (int k = 0; k < j; k++) {
+			diagonal -= (*this)(j, k) * (*this)(j, k);
+		}
+		if (!(diagonal > 0.0)) {
+			return false;
+		}
+		diagonal = std::sqrt(diagonal);
+		(*this)(j, j) = diagonal;
+
+		for (int i = j + 1; i < numRows; i++) {
+			double entry = (*this)(i, j);
+			for (int k = 0; k < j; k++) {
+				entry -= (*this)(i, k) * (*this)(j, k);
+			}
+			(*this)(i, j) = entry / diagonal;
+		}
+	}
+	return true;
+}
+
+/**
+ * Solves LLᵀx = b in place, using the lower triangle from CholeskyFactor
+ *
+ * @param rhs holds b on entry and x on return
+ *
+ * @pre CholeskyFactor returned true
+ */
+void DenseMatrix::CholeskySolve(std::span<double> rhs) const {
+	//Forward substitution: Lz = b
+	for (int i = 0; i < numRows; i++) {
+		double value = rhs[i];
+		for (int k = 0; k < i; k++) {
+			value -= (*this)(i, k) * rhs[k];
+		}
+		rhs[i] = value / (*this)(i, i);
+	}
+	//Back substitution: Lᵀx = z
+	for (int i = numRows - 1; i >= 0; i--) {
+		double value = rhs[i];
+		for (int k = i + 1; k < numRows; k++) {
+			value -= (*this)(k, i) * rhs[k];
+		}
+		rhs[i] = value / (*this)(i, i);
+	}
+}
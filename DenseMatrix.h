@@ -0,0 +1,94 @@
+/**
+ * The Dense Matrix class stores a matrix as one contiguous row-major block,
+ * unlike the vector<vector<double>> Matrix used by the linear least squares
+ * approximation. It provides the kernels needed to solve normal equations:
+ * a Gram (AᵀA) product that never forms Aᵀ, and a Cholesky factorization.
+ */
+#ifndef DENSE_MATRIX_H_INCLUDED
+#define DENSE_MATRIX_H_INCLUDED
+
+#include <span>
+#include <vector>
+
+class DenseMatrix
+{
+private:
+
+	int numRows = 0; //!< Number of rows
+	int numCols = 0; //!< Number of columns
+	std::vector<double> values = {}; //!< Entries, row after row
+
+public:
+
+	/**
+	 * Creates a matrix filled with zeros
+	 *
+	 * @param rows number of rows
+	 * @param cols number of columns
+	 */
+	DenseMatrix(int rows = 0, int cols = 0);
+
+	int Rows() const { return numRows; }
+	int Cols() const { return numCols; }
+
+	double& operator()(int row, int col) { return values[row * numCols + col]; }
+	double operator()(int row, int col) const { return values[row * numCols + col]; }
+
+	/**
+	 * Fetches one row as contiguous storage
+	 *
+	 * @param row index of the row
+	 *
+	 * @return pointer to the first entry of the row
+	 */
+	double* Row(int row) { return values.data() + row * numCols; }
+	const double* Row(int row) const { return values.data() + row * numCols; }
+
+	/**
+	 * Adds AᵀA of the first rows of block to the upper triangle of this matrix.
+	 * A is walked row by row, so Aᵀ is never formed.
+	 *
+	 * @param block row-major matrix A
+	 * @param blockRows number of leading rows of block to use
+	 *
+	 * @pre Rows() == Cols() == block.Cols()
+	 */
+	void AddGramUpper(const DenseMatrix& block, int blockRows);
+
+	/**
+	 * Adds Aᵀy of the first rows of block to rhs
+	 *
+	 * @param block row-major matrix A
+	 * @param blockRows number of leading rows of block to use
+	 * @param y right hand values, one per row of block
+	 * @param rhs updated with Aᵀy (size block.Cols())
+	 */
+	static void AddTransposeProduct(const DenseMatrix& block, int blockRows, std::span<const double> y, std::span<double> rhs);
+
+	/**
+	 * Copies the upper triangle into the lower triangle
+	 *
+	 * @pre Rows() == Cols()
+	 */
+	void MirrorUpper();
+
+	/**
+	 * Replaces the lower triangle with L from A = LLᵀ. Only the lower
+	 * triangle (and diagonal) of this matrix is read.
+	 *
+	 * @return false if the matrix is not symmetric positive-definite
+	 *
+	 * @pre Rows() == Cols()
+	 */
+	bool CholeskyFactor();
+
+	/**
+	 * Solves LLᵀx = b in place, using the lower triangle from CholeskyFactor
+	 *
+	 * @param rhs holds b on entry and x on return
+	 *
+	 * @pre CholeskyFactor returned true
+	 */
+	void CholeskySolve(std::span<double> rhs) const;
+};
+#endif
@@ -0,0 +1,177 @@
+#include "InterpolantEvaluator.h"
+
+#include <algorithm>
+#include <cmath>
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Fills eytzingerTimes and eytzingerRanks by an in-order walk of the implicit tree
+ *
+ * @param node position in the Eytzinger layout (1 is the root)
+ * @param nextRank next position of knotTimes to place
+ *
+ * @return the next position of knotTimes still to place
+ */
+std::size_t InterpolantEvaluator::BuildEytzinger(std::size_t node, std::size_t nextRank) {
+	if (node >= eytzingerTimes.size()) {
+		return nextRank;
+	}
+	nextRank = BuildEytzinger(2 * node, nextRank);
+	eytzingerTimes[node] = knotTimes[nextRank];
+	eytzingerRanks[node] = nextRank;
+	return BuildEytzinger(2 * node + 1, nextRank + 1);
+}
+
+/**
+ * Finds the interpolation covering a time when the times are evenly spaced
+ *
+ * @param time time to look up
+ *
+ * @return index of the interpolation
+ */
+std::size_t InterpolantEvaluator::LocateUniform(double time) const {
+	double position = std::floor((time - firstTime) * inverseStep);
+	if (!(position > 0.0)) {
+		return 0;
+	}
+	std::size_t segment = position < numSegments ? static_cast<std::size_t>(position) : numSegments - 1;
+
+	//The multiply can land one interpolation off right at a reading
+	if (segment + 1 < numSegments && time >= knotTimes[segment + 1]) {
+		segment++;
+	}
+	else if (segment > 0 && time < knotTimes[segment]) {
+		segment--;
+	}
+	return segment;
+}
+
+/**
+ * Finds the interpolation covering a time with a branchless Eytzinger search
+ *
+ * @param time time to look up
+ *
+ * @return index of the interpolation
+ */
+std::size_t InterpolantEvaluator::LocateSearch(double time) const {
+	//Walk down the tree looking for the first reading after time
+	std::size_t node = 1;
+	std::size_t treeSize = eytzingerTimes.size();
+	while (node < treeSize) {
+		__builtin_prefetch(eytzingerTimes.data() + std::min(16 * node, treeSize - 1));
+		node = 2 * node + (eytzingerTimes[node] <= time);
+	}
+	//Undo the right turns taken after the last left turn
+	node >>= __builtin_ffsll(~node);
+
+	//node 0 means no reading is after time
+	std::size_t firstAfter = node == 0 ? knotTimes.size() : eytzingerRanks[node];
+	if (firstAfter == 0) {
+		return 0;
+	}
+	return firstAfter - 1 < numSegments ? firstAfter - 1 : numSegments - 1;
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Prepares an evaluator for one core
+ *
+ * @param times provides the times of the readings, ascending
+ * @param coreSlopes provides the slope of each interpolation (times.size() - 1 of them)
+ * @param coreIntercepts provides the y-intercept of each interpolation
+ */
+InterpolantEvaluator::InterpolantEvaluator(std::span<const int> times, std::span<const double> coreSlopes, std::span<const double> coreIntercepts)
+	: knotTimes(times.begin(), times.end()),
+	  slopes(coreSlopes.begin(), coreSlopes.end()),
+	  intercepts(coreIntercepts.begin(), coreIntercepts.end()) {
+	numSegments = times.size() > 1 ? times.size() - 1 : 0;
+	if (numSegments == 0) {
+		return;
+	}
+
+	firstTime = knotTimes[0];
+	int step = times[1] - times[0];
+	uniform = step > 0;
+	for (std::size_t i = 1; uniform && i < times.size(); i++) {
+		uniform = times[i] - times[i - 1] == step;
+	}
+
+	if (uniform) {
+		inverseStep = 1.0 / step;
+	}
+	else {
+		eytzingerTimes.resize(knotTimes.size() + 1);
+		eytzingerRanks.resize(knotTimes.size() + 1);
+		BuildEytzinger(1, 0);
+	}
+}
+
+/**
+ * Evaluates the interpolation at one time
+ *
+ * @param time time to evaluate at
+ *
+ * @return the interpolated temperature (0 if there are no interpolations)
+ */
+double InterpolantEvaluator::Evaluate(double time) const {
+	if (numSegments == 0) {
+		return 0.0;
+	}
+	std::size_t segment = Locate(time);
+	return intercepts[segment] + slopes[segment] * time;
+}
+
+/**
+ * Evaluates the interpolation at many times, in any order
+ *
+ * @param queryTimes times to evaluate at
+ * @param temps updated with the temperature at each query time
+ *
+ * @pre temps.size() >= queryTimes.size()
+ */
+void InterpolantEvaluator::Evaluate(std::span<const double> queryTimes, std::span<double> temps) const {
+	for (std::size_t i = 0; i < queryTimes.size(); i++) {
+		temps[i] = Evaluate(queryTimes[i]);
+	}
+}
+
+/**
+ * Evaluates the interpolation at many ascending times. The interpolations
+ * are found with one sweep that moves forward alongside the queries, then
+ * the temperatures are worked out in a separate loop that vectorizes.
+ *
+ * @param queryTimes times to evaluate at, ascending
+ * @param temps updated with the temperature at each query time
+ *
+ * @pre temps.size() >= queryTimes.size()
+ */
+void InterpolantEvaluator::EvaluateSorted(std::span<const double> queryTimes, std::span<double> temps) const {
+	if (numSegments == 0) {
+		for (std::size_t i = 0; i < queryTimes.size(); i++) {
+			temps[i] = 0.0;
+		}
+		return;
+	}
+
+	std::size_t blockSegments[SWEEP_BLOCK];
+	std::size_t segment = 0;
+	for (std::size_t start = 0; start < queryTimes.size(); start += SWEEP_BLOCK) {
+		std::size_t blockSize = std::min(SWEEP_BLOCK, queryTimes.size() - start);
+		const double* blockTimes = queryTimes.data() + start;
+
+		//Merge: the covering interpolation only ever moves forward
+		for (std::size_t i = 0; i < blockSize; i++) {
+			while (segment + 1 < numSegments && knotTimes[segment + 1] <= blockTimes[i]) {
+				segment++;
+			}
+			blockSegments[i] = segment;
+		}
+
+		double* blockTemps = temps.data() + start;
+		for (std::size_t i = 0; i < blockSize; i++) {
+			blockTemps[i] = intercepts[blockSegments[i]] + slopes[blockSegments[i]] * blockTimes[i];
+		}
+	}
+}
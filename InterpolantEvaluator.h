@@ -0,0 +1,123 @@
+/**
+ * The Interpolant Evaluator class answers "temperature at time t" queries
+ * from the piecewise linear interpolation of one core. Finding the
+ * interpolation that covers t is O(1) when the times are evenly spaced;
+ * otherwise a branchless search over an Eytzinger (breadth-first) layout
+ * of the times is used. Sorted batches of queries are handled with a
+ * merge-style sweep.
+ *
+ * Times before the first reading use the first interpolation and times
+ * after the last reading use the last one.
+ */
+#ifndef INTERPOLANT_EVALUATOR_H_INCLUDED
+#define INTERPOLANT_EVALUATOR_H_INCLUDED
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+class InterpolantEvaluator
+{
+private:
+
+	static constexpr std::size_t SWEEP_BLOCK = 256; //!< Queries located at a time by EvaluateSorted
+
+	std::vector<double> knotTimes = {}; //!< Times of the readings, in order (one more than interpolations)
+	std::vector<double> slopes = {}; //!< Slope of every interpolation
+	std::vector<double> intercepts = {}; //!< Y-intercept of every interpolation
+	std::size_t numSegments = 0; //!< Number of interpolations
+
+	bool uniform = false; //!< Whether the times are evenly spaced
+	double firstTime = 0.0; //!< Time of the first reading
+	double inverseStep = 0.0; //!< 1 / spacing of the times (uniform only)
+
+	std::vector<double> eytzingerTimes = {}; //!< knotTimes in Eytzinger order, 1-indexed (irregular only)
+	std::vector<std::size_t> eytzingerRanks = {}; //!< Position in knotTimes of every eytzingerTimes entry
+
+	/**
+	 * Fills eytzingerTimes and eytzingerRanks by an in-order walk of the implicit tree
+	 *
+	 * @param node position in the Eytzinger layout (1 is the root)
+	 * @param nextRank next position of knotTimes to place
+	 *
+	 * @return the next position of knotTimes still to place
+	 */
+	std::size_t BuildEytzinger(std::size_t node, std::size_t nextRank);
+
+	/**
+	 * Finds the interpolation covering a time when the times are evenly spaced
+	 *
+	 * @param time time to look up
+	 *
+	 * @return index of the interpolation
+	 */
+	std::size_t LocateUniform(double time) const;
+
+	/**
+	 * Finds the interpolation covering a time with a branchless Eytzinger search
+	 *
+	 * @param time time to look up
+	 *
+	 * @return index of the interpolation
+	 */
+	std::size_t LocateSearch(double time) const;
+
+	/**
+	 * Finds the interpolation covering a time with whichever method fits the times
+	 *
+	 * @param time time to look up
+	 *
+	 * @return index of the interpolation
+	 */
+	std::size_t Locate(double time) const { return uniform ? LocateUniform(time) : LocateSearch(time); }
+
+public:
+
+	/**
+	 * Prepares an evaluator for one core
+	 *
+	 * @param times provides the times of the readings, ascending
+	 * @param coreSlopes provides the slope of each interpolation (times.size() - 1 of them)
+	 * @param coreIntercepts provides the y-intercept of each interpolation
+	 */
+	InterpolantEvaluator(std::span<const int> times, std::span<const double> coreSlopes, std::span<const double> coreIntercepts);
+
+	/**
+	 * Reports if the O(1) evenly spaced lookup is in use
+	 *
+	 * @return true if the times are evenly spaced
+	 */
+	bool IsUniform() const { return uniform; }
+
+	/**
+	 * Evaluates the interpolation at one time
+	 *
+	 * @param time time to evaluate at
+	 *
+	 * @return the interpolated temperature (0 if there are no interpolations)
+	 */
+	double Evaluate(double time) const;
+
+	/**
+	 * Evaluates the interpolation at many times, in any order
+	 *
+	 * @param queryTimes times to evaluate at
+	 * @param temps updated with the temperature at each query time
+	 *
+	 * @pre temps.size() >= queryTimes.size()
+	 */
+	void Evaluate(std::span<const double> queryTimes, std::span<double> temps) const;
+
+	/**
+	 * Evaluates the interpolation at many ascending times. The interpolations
+	 * are found with one sweep that moves forward alongside the queries, then
+	 * the temperatures are worked out in a separate loop that vectorizes.
+	 *
+	 * @param queryTimes times to evaluate at, ascending
+	 * @param temps updated with the temperature at each query time
+	 *
+	 * @pre temps.size() >= queryTimes.size()
+	 */
+	void EvaluateSorted(std::span<const double> queryTimes, std::span<double> temps) const;
+};
+#endif
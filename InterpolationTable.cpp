@@ -0,0 +1,17 @@
+#include "InterpolationTable.h"
+
+/**
+ * Sizes the table, discarding previous contents
+ *
+ * @param cores number of core columns
+ * @param segments number of interpolations per core
+ */
+void InterpolationTable::Resize(int cores, std::size_t segments) {
+	const std::size_t perLine = CACHE_LINE_SIZE / sizeof(double);
+	numCores = cores;
+	numSegments = segments;
+	columnStride = (segments + perLine - 1) / perLine * perLine;
+
+	slopes.assign(columnStride * cores, 0.0);
+	intercepts.assign(columnStride * cores, 0.0);
+}
@@ -0,0 +1,72 @@
+/**
+ * The Interpolation Table class holds the piecewise linear interpolation of
+ * every core. Slopes and y-intercepts are kept in separate arrays, one
+ * cache aligned column per core, so batch kernels can stream through them.
+ */
+#ifndef INTERPOLATION_TABLE_H_INCLUDED
+#define INTERPOLATION_TABLE_H_INCLUDED
+
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "CacheAlignedAllocator.h"
+
+class InterpolationTable
+{
+private:
+
+	int numCores = 0; //!< Number of core columns
+	std::size_t numSegments = 0; //!< Number of interpolations per core
+	std::size_t columnStride = 0; //!< Distance between the starts of two core columns, padded to a cache line
+
+	std::vector<double, CacheAlignedAllocator<double>> slopes; //!< Slope (m) of every interpolation, one column per core
+	std::vector<double, CacheAlignedAllocator<double>> intercepts; //!< Y-intercept (b) of every interpolation, one column per core
+
+public:
+
+	/**
+	 * Creates an empty table
+	 *
+	 * @param resource where the columns are allocated (i.e. a PipelineArena)
+	 */
+	InterpolationTable(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		: slopes(resource), intercepts(resource) {}
+
+	/**
+	 * Sizes the table, discarding previous contents
+	 *
+	 * @param cores number of core columns
+	 * @param segments number of interpolations per core
+	 */
+	void Resize(int cores, std::size_t segments);
+
+	int GetNumCores() const { return numCores; }
+	std::size_t GetNumSegments() const { return numSegments; }
+
+	/**
+	 * Fetches the slopes of one core
+	 *
+	 * @param coreNum specifies which core
+	 *
+	 * @return a view of the slopes, one per interpolation
+	 *
+	 * @pre coreNum >= 0 && coreNum < GetNumCores()
+	 */
+	std::span<double> GetSlopes(int coreNum) { return { slopes.data() + coreNum * columnStride, numSegments }; }
+	std::span<const double> GetSlopes(int coreNum) const { return { slopes.data() + coreNum * columnStride, numSegments }; }
+
+	/**
+	 * Fetches the y-intercepts of one core
+	 *
+	 * @param coreNum specifies which core
+	 *
+	 * @return a view of the y-intercepts, one per interpolation
+	 *
+	 * @pre coreNum >= 0 && coreNum < GetNumCores()
+	 */
+	std::span<double> GetIntercepts(int coreNum) { return { intercepts.data() + coreNum * columnStride, numSegments }; }
+	std::span<const double> GetIntercepts(int coreNum) const { return { intercepts.data() + coreNum * columnStride, numSegments }; }
+};
+#endif
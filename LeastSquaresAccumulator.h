@@ -0,0 +1,112 @@
+/**
+ * The Least Squares Accumulator class folds (time, temp) samples into the
+ * running sums that make up xTx and xTy of the linear least squares
+ * approximation. Memory use does not depend on the number of samples, so a
+ * log can be fitted while it is being read.
+ */
+#ifndef LEAST_SQUARES_ACCUMULATOR_H_INCLUDED
+#define LEAST_SQUARES_ACCUMULATOR_H_INCLUDED
+
+#include <cmath>
+
+/**
+ * A running sum using Neumaier's compensated summation. The lost low order
+ * bits of every addition are kept in a separate term so long sums do not
+ * drift.
+ */
+class CompensatedSum
+{
+private:
+
+	double sum = 0.0; //!< Running total
+	double compensation = 0.0; //!< Low order bits lost from sum
+
+public:
+
+	/**
+	 * Adds a value to the sum
+	 *
+	 * @param value number to add
+	 */
+	void Add(double value) {
+		double total = sum + value;
+		if (std::fabs(sum) >= std::fabs(value)) {
+			compensation += (sum - total) + value;
+		}
+		else {
+			compensation += (value - total) + sum;
+		}
+		sum = total;
+	}
+
+	/**
+	 * Adds another compensated sum to this one
+	 *
+	 * @param other sum to fold in
+	 */
+	void Merge(const CompensatedSum& other) {
+		Add(other.sum);
+		compensation += other.compensation;
+	}
+
+	/**
+	 * Fetches the compensated total
+	 *
+	 * @return the sum of every added value
+	 */
+	double Value() const { return sum + compensation; }
+};
+
+class LeastSquaresAccumulator
+{
+private:
+
+	long long count = 0; //!< Number of samples folded in (sum of 1 * 1)
+	CompensatedSum sumTimes; //!< Sum of time
+	CompensatedSum sumTimesSquared; //!< Sum of time * time
+	CompensatedSum sumTemps; //!< Sum of temp
+	CompensatedSum sumTimesTemps; //!< Sum of time * temp
+
+public:
+
+	/**
+	 * Folds one sample into the running sums
+	 *
+	 * @param time time of the reading
+	 * @param temp temp associated with the time reading
+	 */
+	void Add(int time, double temp) {
+		double t = time;
+		count++;
+		sumTimes.Add(t);
+		sumTimesSquared.Add(t * t);
+		sumTemps.Add(temp);
+		sumTimesTemps.Add(t * temp);
+	}
+
+	/**
+	 * Folds the samples of another accumulator into this one. Used to combine
+	 * partial sums built over separate parts of a log.
+	 *
+	 * @param other accumulator to fold in
+	 */
+	void Merge(const LeastSquaresAccumulator& other) {
+		count += other.count;
+		sumTimes.Merge(other.sumTimes);
+		sumTimesSquared.Merge(other.sumTimesSquared);
+		sumTemps.Merge(other.sumTemps);
+		sumTimesTemps.Merge(other.sumTimesTemps);
+	}
+
+	/**
+	 * Clears all samples so the accumulator can be reused
+	 */
+	void Reset() { *this = LeastSquaresAccumulator(); }
+
+	long long GetCount() const { return count; }
+	double GetSumTimes() const { return sumTimes.Value(); }
+	double GetSumTimesSquared() const { return sumTimesSquared.Value(); }
+	double GetSumTemps() const { return sumTemps.Value(); }
+	double GetSumTimesTemps() const { return sumTimesTemps.Value(); }
+};
+#endif
@@ -1,26 +1,29 @@
 #include "LeastSquaresApproximation.h"
 
+#include <algorithm>
+
 //--------------------- Private Functions -----------------------//
 
 /**
- * Will set up the Matrices x, y, xT, xTx,xTy
+ * Will set up the Matrices x, y, xT, xTx,xTy. Any Matrices left over from
+ * a previous calculation are cleared first.
  *
  * @param times provides list of the times
  * @param temps provides list of the temps of the target core
  */
-void LeastSquaresApproximation::Setup(const std::vector<int>& times, const std::vector<double>& temps) {
+void LeastSquaresApproximation::Setup(std::span<const int> times, std::span<const double> temps) {
+	x.clear();
+	y.clear();
+	//Rows are built in place so they take their storage from resource
+	x.reserve(times.size());
+	y.reserve(temps.size());
 	//Initialize x
 	for (int i = 0; i < times.size(); i++) {
-		std::vector<double> rowStorage;
-		rowStorage.push_back(1);
-		rowStorage.push_back(times[i]);
-		x.push_back(rowStorage);
+		x.emplace_back() = { 1.0, static_cast<double>(times[i]) };
 	}
 	//Initialize y
 	for (int i = 0; i < temps.size(); i++) {
-		std::vector<double> rowStorage;
-		rowStorage.push_back(temps[i]);
-		y.push_back(rowStorage);
+		y.emplace_back() = { temps[i] };
 	}
 	//Initialize xT
 	xT = Transpose(x);
@@ -36,19 +39,19 @@ void LeastSquaresApproximation::Setup(const std::vector<int>& times, const std::
  *
  * @return the transpose Matrix
  *
- * @pre Matrix is implemented as vector<vector<double>>
+ * @pre Matrix is implemented as pmr::vector<pmr::vector<double>>
  */
 Matrix LeastSquaresApproximation::Transpose(const Matrix& toTranspose) {
-	Matrix retVal;
+	Matrix retVal(resource);
 	//Column Num -> Reminder we decided Matrix is row outside column inside
 	for (int j = 0; j < toTranspose[j].size(); j++) {
-		std::vector<double> columnStore;
+		//Push the column as a row
+		std::pmr::vector<double>& columnStore = retVal.emplace_back();
+		columnStore.reserve(toTranspose.size());
 		//Row Num
 		for (int i = 0; i < toTranspose.size(); i++) {
 			columnStore.push_back(toTranspose[i][j]);
 		}
-		//Push the column as a row
-		retVal.push_back(columnStore);
 	}
 	return retVal;
 }
@@ -65,14 +68,14 @@ Matrix LeastSquaresApproximation::Transpose(const Matrix& toTranspose) {
  *
  * @return Matrix that is the m x p ; the dot product of the provided Matrices
  *
- * @pre Matrix is implemented as vector<vector<double>>
+ * @pre Matrix is implemented as pmr::vector<pmr::vector<double>>
  * @pre lhs column # == rhs row #
  */
 Matrix LeastSquaresApproximation::MatrixDotProduct(const Matrix& lhs, const Matrix& rhs) {
-	Matrix retVal;
+	Matrix retVal(resource);
 	//Row of lhs moves down last (m)
 	for (int lhsRowNum = 0; lhsRowNum < lhs.size(); lhsRowNum++) {
-		std::vector<double> rowStore;
+		std::pmr::vector<double>& rowStore = retVal.emplace_back();
 		//Column of rhs moves before row of lhs, but after calcs (p)
 		for (int rhsColumnNum = 0; rhsColumnNum < rhs[rhsColumnNum].size(); rhsColumnNum++) {
 			double val = 0.0;
@@ -82,7 +85,6 @@ Matrix LeastSquaresApproximation::MatrixDotProduct(const Matrix& lhs, const Matr
 			}
 			rowStore.push_back(val);
 		}
-		retVal.push_back(rowStore);
 	}
 	return retVal;
 }
@@ -91,16 +93,18 @@ Matrix LeastSquaresApproximation::MatrixDotProduct(const Matrix& lhs, const Matr
  * Takes a matrix on the left and an augmented vector (aka verticle vector)
  * and solves it before performing row operations until the left hand matrix is
  * an identity matrix and the augmented vector is changed by those operations.
+ * Every column of the augmented vector is a separate right hand side, so one
+ * elimination solves all of them.
  *
  * @param lhsMatrix takes the matrix to perform row operations on (nxn)
- * @param augVector takes the augmented vector to peform row operations on (nx1)
+ * @param augVector takes the augmented vector to peform row operations on (nxk)
  *
- * @return a augmented vector with the updated values
+ * @return a augmented vector with the updated values (nxk)
  */
 Matrix LeastSquaresApproximation::SolveMatrix(const Matrix& lhsMatrix, const Matrix& augVector) {
 	//Store for editting
-	Matrix retVector = augVector;
-	Matrix solvingMatrix = lhsMatrix;
+	Matrix retVector(augVector, resource);
+	Matrix solvingMatrix(lhsMatrix, resource);
 	
 	for (int i = 0; i < lhsMatrix.size(); i++) {
 		Pivot(solvingMatrix, retVector, i, i);
@@ -135,15 +139,10 @@ void LeastSquaresApproximation::Pivot(Matrix& lhsMatrix, Matrix& augVector, int
 	//Swap if needed
 	if (maxRow != startRow) {
 		//Swap left matrix first
-		std::vector<double> tempRow;
-		tempRow = lhsMatrix[startRow];
-		lhsMatrix[startRow] = lhsMatrix[maxRow];
-		lhsMatrix[maxRow] = tempRow;
+		lhsMatrix[startRow].swap(lhsMatrix[maxRow]);
 
 		//Swap the aug vector to match
-		tempRow = augVector[startRow];
-		augVector[startRow] = augVector[maxRow];
-		augVector[maxRow] = tempRow;
+		augVector[startRow].swap(augVector[maxRow]);
 	}
 }
 
@@ -187,7 +186,9 @@ void LeastSquaresApproximation::Eliminate(Matrix& lhsMatrix, Matrix& augVector,
 		for (int j = startColumn + 1; j < lhsMatrix[i].size(); j++) {
 			lhsMatrix[i][j] = lhsMatrix[i][j] - (scalar * lhsMatrix[sourceRow][j]);
 		}
-		augVector[i][0] = augVector[i][0] - (scalar * augVector[sourceRow][0]);
+		for (int j = 0; j < augVector[i].size(); j++) {
+			augVector[i][j] = augVector[i][j] - (scalar * augVector[sourceRow][j]);
+		}
 		lhsMatrix[i][startColumn] = 0;
 	}
 }
@@ -209,13 +210,24 @@ void LeastSquaresApproximation::BackEliminate(Matrix& lhsMatrix, Matrix& augVect
 		for (int j = lastColNum - 1; j >= 0; j--) {
 			lhsMatrix[i][j] = lhsMatrix[i][j] - (scalar * lhsMatrix[i+1][lastColNum]);
 		}
-		augVector[i][0] = augVector[i][0] - (scalar * augVector[i+1][0]);
+		for (int j = 0; j < augVector[i].size(); j++) {
+			augVector[i][j] = augVector[i][j] - (scalar * augVector[i+1][j]);
+		}
 		lastColNum--;
 	}
 }
 
 //--------------------- Public Functions -----------------------//
 
+/**
+ * Creates a calculator whose Matrices are allocated from a memory resource
+ *
+ * @param resource where the Matrices are allocated (i.e. a PipelineArena)
+ */
+LeastSquaresApproximation::LeastSquaresApproximation(std::pmr::memory_resource* resource)
+	: resource(resource), x(resource), y(resource), xT(resource), xTx(resource), xTy(resource) {
+}
+
 /**
  * Calculates all the slope (c1) and intercept (c0) for the least squares-approximation
  *
@@ -226,7 +238,7 @@ void LeastSquaresApproximation::BackEliminate(Matrix& lhsMatrix, Matrix& augVect
  *
  * @pre Assumes temps[i] associates with times[i]
  */
-SlopeAndIntercept LeastSquaresApproximation::Calculate(const std::vector<int>& times, const std::vector<double>& temps) {
+SlopeAndIntercept LeastSquaresApproximation::Calculate(std::span<const int> times, std::span<const double> temps) {
 	Setup(times, temps);
 	Matrix solved = SolveMatrix(xTx,xTy);
 	double c1 = solved[1][0];
@@ -235,6 +247,87 @@ SlopeAndIntercept LeastSquaresApproximation::Calculate(const std::vector<int>& t
 	return retVal;
 }
 
+/**
+ * Calculates the slope (c1) and intercept (c0) from the running sums of a
+ * streaming accumulator. xTx and xTy are built straight from the sums, so
+ * the samples never need to be held in memory.
+ *
+ * @param samples accumulator holding every (time, temp) of the target core
+ *
+ * @return a std::pair<double, double> that contains c1 and c0 respectively
+ *
+ * @pre samples has at least two distinct times
+ */
+SlopeAndIntercept LeastSquaresApproximation::Calculate(const LeastSquaresAccumulator& samples) {
+	Matrix sumsXTX({ { static_cast<double>(samples.GetCount()), samples.GetSumTimes() },
+					 { samples.GetSumTimes(), samples.GetSumTimesSquared() } }, resource);
+	Matrix sumsXTY({ { samples.GetSumTemps() },
+					 { samples.GetSumTimesTemps() } }, resource);
+
+	Matrix solved = SolveMatrix(sumsXTX, sumsXTY);
+	double c1 = solved[1][0];
+	double c0 = solved[0][0];
+	SlopeAndIntercept retVal(c1, c0);
+	return retVal;
+}
+
+/**
+ * Calculates the slope (c1) and intercept (c0) of every core at once. xTx
+ * only depends on the times, so it is summed and eliminated once and each
+ * core's xTy is one column of the right hand side. xTy is summed a block of
+ * readings at a time, so the block of times stays in cache while every
+ * core's column streams past it.
+ *
+ * The sums and row operations are the same as Calculate(LeastSquaresAccumulator)
+ * does per core, so the results match it exactly.
+ *
+ * @param fits updated with c1 and c0 of every core respectively
+ * @param data provides the times and the temps of every core
+ *
+ * @pre fits.size() >= data.GetNumCores() and there are at least two distinct times
+ */
+void LeastSquaresApproximation::Calculate(std::span<SlopeAndIntercept> fits, const DataPreProcessor& data) {
+	std::span<const int> times = data.GetTimes();
+	int numCores = data.GetNumCores();
+
+	CompensatedSum sumTimes;
+	CompensatedSum sumTimesSquared;
+	std::pmr::vector<CompensatedSum> sumTemps(numCores, resource);
+	std::pmr::vector<CompensatedSum> sumTimesTemps(numCores, resource);
+	for (std::size_t blockStart = 0; blockStart < times.size(); blockStart += BLOCK_ROWS) {
+		std::size_t blockEnd = std::min(times.size(), blockStart + BLOCK_ROWS);
+		for (std::size_t i = blockStart; i < blockEnd; i++) {
+			double t = times[i];
+			sumTimes.Add(t);
+			sumTimesSquared.Add(t * t);
+		}
+		for (int core = 0; core < numCores; core++) {
+			const double* temps = data.GetCoreReadings(core).data();
+			CompensatedSum& coreSumTemps = sumTemps[core];
+			CompensatedSum& coreSumTimesTemps = sumTimesTemps[core];
+			for (std::size_t i = blockStart; i < blockEnd; i++) {
+				double t = times[i];
+				coreSumTemps.Add(temps[i]);
+				coreSumTimesTemps.Add(t * temps[i]);
+			}
+		}
+	}
+
+	Matrix sumsXTX({ { static_cast<double>(times.size()), sumTimes.Value() },
+					 { sumTimes.Value(), sumTimesSquared.Value() } }, resource);
+	//One column per core
+	Matrix sumsXTY(2, resource);
+	for (int core = 0; core < numCores; core++) {
+		sumsXTY[0].push_back(sumTemps[core].Value());
+		sumsXTY[1].push_back(sumTimesTemps[core].Value());
+	}
+
+	Matrix solved = SolveMatrix(sumsXTX, sumsXTY);
+	for (int core = 0; core < numCores; core++) {
+		fits[core] = SlopeAndIntercept(solved[1][core], solved[0][core]);
+	}
+}
+
 //Need a toString method like the piecewise in order to print a line
 //Format minTime <= x < maxTime; y = c0 + c1x; least-squares
 
@@ -249,18 +342,20 @@ SlopeAndIntercept LeastSquaresApproximation::Calculate(const std::vector<int>& t
  *
  * @return string to be used in output
  */
-const std::string LeastSquaresApproximation::ToString(const SlopeAndIntercept& coreSquareApprox, const std::vector<int>& times) {
-	std::stringstream retVal;
-	//Sets significant figs
-	retVal << std::setprecision(4) << std::fixed;
-	int spacing = 8;
-
-	retVal << std::right << std::setfill(' ') << std::setw(spacing) << times[0] << " <= x <"
-		   << std::right << std::setfill(' ') << std::setw(spacing) << times[times.size()-1] << "; y "
-		<< std::left << std::setfill(' ') << std::setw(spacing) << " " << " = "
-		   << std::right << std::setfill(' ') << std::setw(spacing + (spacing / 2)) << coreSquareApprox.second << " + "
-		   << std::right << std::setfill(' ') << std::setw(spacing + (spacing / 2)) << coreSquareApprox.first << "x; least-squares"
-		   << "\n";
+const std::string LeastSquaresApproximation::ToString(const SlopeAndIntercept& coreSquareApprox, std::span<const int> times) {
+	ReportFormatter retVal;
+	AppendTo(retVal, coreSquareApprox, times);
+	return retVal.Take();
+}
 
-	return retVal.str();
-}
\ No newline at end of file
+/**
+ * Appends the formatted line of the least squares approximation for a core
+ * to a report, using the same format as ToString
+ *
+ * @param report formatter to write the line into
+ * @param coreSquareApprox provides the slope (c1) and intercept (c0) for the approximation
+ * @param times provides the limits of the approximation
+ */
+void LeastSquaresApproximation::AppendTo(ReportFormatter& report, const SlopeAndIntercept& coreSquareApprox, std::span<const int> times) {
+	report.AppendLeastSquares(times[0], times[times.size() - 1], coreSquareApprox.second, coreSquareApprox.first);
+}
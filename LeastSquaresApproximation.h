@@ -8,28 +8,37 @@
 #ifndef LEAST_SQUARES_APPROXIMATION_H_INCLUDED
 #define LEAST_SQUARES_APPROXIMATION_H_INCLUDED
 
+#include <cstddef>
+#include <memory_resource>
 #include <string>
-#include <iomanip>
-#include <sstream>
+#include <span>
 #include <vector>
 #include <utility>
 
+#include "DataPreProcessor.h"
+#include "LeastSquaresAccumulator.h"
+#include "ReportFormatter.h"
+
 using SlopeAndIntercept = std::pair<double, double>;
-using Matrix = std::vector<std::vector<double>>; //Outside vector = row, inside = column
+using Matrix = std::pmr::vector<std::pmr::vector<double>>; //Outside vector = row, inside = column
 
 class LeastSquaresApproximation
 {
 private:
 
+	static constexpr std::size_t BLOCK_ROWS = 1024; //!< Readings of every core summed before moving to the next block
+
+	std::pmr::memory_resource* resource; //!< Where the Matrices are allocated
 	Matrix x, y, xT, xTx, xTy; //!< List of Matrices to be used in calculations
 
 	/**
-	 * Will set up the Matrices x, y, xT, xTx,xTy
+	 * Will set up the Matrices x, y, xT, xTx,xTy. Any Matrices left over from
+	 * a previous calculation are cleared first.
 	 * 
 	 * @param times provides list of the times
 	 * @param temps provides list of the temps of the target core
 	 */
-	void Setup(const std::vector<int>& times, const std::vector<double>& temps);
+	void Setup(std::span<const int> times, std::span<const double> temps);
 
 	/**
 	 * Will transpose a provide Matrix
@@ -38,7 +47,7 @@ private:
 	 * 
 	 * @return the transpose Matrix
 	 * 
-	 * @pre Matrix is implemented as vector<vector<double>>
+	 * @pre Matrix is implemented as pmr::vector<pmr::vector<double>>
 	 */
 	Matrix Transpose(const Matrix& toTranspose);
 
@@ -54,7 +63,7 @@ private:
 	 * 
 	 * @return Matrix that is the m x p ; the dot product of the provided Matrices
 	 * 
-	 * @pre Matrix is implemented as vector<vector<double>>
+	 * @pre Matrix is implemented as pmr::vector<pmr::vector<double>>
 	 * @pre lhs column # == rhs row #
 	 */
 	Matrix MatrixDotProduct(const Matrix& lhs, const Matrix& rhs);
@@ -65,11 +74,13 @@ private:
 	 * Takes a matrix on the left and an augmented vector (aka verticle vector)
 	 * and solves it before performing row operations until the left hand matrix is
 	 * an identity matrix and the augmented vector is changed by those operations.
+	 * Every column of the augmented vector is a separate right hand side, so one
+	 * elimination solves all of them.
 	 * 
-	 * @param lhsMatrix takes the matrix to perform row operations on
-	 * @param augVector takes the augmented vector to peform row operations on
+	 * @param lhsMatrix takes the matrix to perform row operations on (nxn)
+	 * @param augVector takes the augmented vector to peform row operations on (nxk)
 	 * 
-	 * @return a augmented vector with the updated values
+	 * @return a augmented vector with the updated values (nxk)
 	 */
 	Matrix SolveMatrix(const Matrix& lhsMatrix, const Matrix& augVector);
 	
@@ -121,6 +132,13 @@ private:
 	void BackEliminate(Matrix& lhsMatrix, Matrix& augVector);
 public:
 
+	/**
+	 * Creates a calculator whose Matrices are allocated from a memory resource
+	 *
+	 * @param resource where the Matrices are allocated (i.e. a PipelineArena)
+	 */
+	LeastSquaresApproximation(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
 	/**
 	 * Calculates all the slope (c1) and intercept (c0) for the least squares-approximation
 	 *
@@ -131,7 +149,37 @@ public:
 	 * 
 	 * @pre Assumes temps[i] associates with times[i]
 	 */
-	SlopeAndIntercept Calculate(const std::vector<int>& times, const std::vector<double>& temps);
+	SlopeAndIntercept Calculate(std::span<const int> times, std::span<const double> temps);
+
+	/**
+	 * Calculates the slope (c1) and intercept (c0) from the running sums of a
+	 * streaming accumulator. xTx and xTy are built straight from the sums, so
+	 * the samples never need to be held in memory.
+	 *
+	 * @param samples accumulator holding every (time, temp) of the target core
+	 *
+	 * @return a std::pair<double, double> that contains c1 and c0 respectively
+	 *
+	 * @pre samples has at least two distinct times
+	 */
+	SlopeAndIntercept Calculate(const LeastSquaresAccumulator& samples);
+
+	/**
+	 * Calculates the slope (c1) and intercept (c0) of every core at once. xTx
+	 * only depends on the times, so it is summed and eliminated once and each
+	 * core's xTy is one column of the right hand side. xTy is summed a block of
+	 * readings at a time, so the block of times stays in cache while every
+	 * core's column streams past it.
+	 *
+	 * The sums and row operations are the same as Calculate(LeastSquaresAccumulator)
+	 * does per core, so the results match it exactly.
+	 *
+	 * @param fits updated with c1 and c0 of every core respectively
+	 * @param data provides the times and the temps of every core
+	 *
+	 * @pre fits.size() >= data.GetNumCores() and there are at least two distinct times
+	 */
+	void Calculate(std::span<SlopeAndIntercept> fits, const DataPreProcessor& data);
 
 	//Need a toString method like the piecewise in order to print a line
 	//Format minTime <= x < maxTime; y = c0 + c1x; least-squares
@@ -147,6 +195,16 @@ public:
 	 *
 	 * @return string to be used in output
 	 */
-	const std::string ToString(const SlopeAndIntercept& coreSquareApprox, const std::vector<int>& times);
+	const std::string ToString(const SlopeAndIntercept& coreSquareApprox, std::span<const int> times);
+
+	/**
+	 * Appends the formatted line of the least squares approximation for a core
+	 * to a report, using the same format as ToString
+	 *
+	 * @param report formatter to write the line into
+	 * @param coreSquareApprox provides the slope (c1) and intercept (c0) for the approximation
+	 * @param times provides the limits of the approximation
+	 */
+	void AppendTo(ReportFormatter& report, const SlopeAndIntercept& coreSquareApprox, std::span<const int> times);
 };
 #endif
\ No newline at end of file
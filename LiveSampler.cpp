@@ -0,0 +1,137 @@
+#include "LiveSampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "LogFollower.h"
+
+namespace {
+	/**
+	 * Appends one sample to a text log line, in the lm-sensors format
+	 * parse_raw_temps reads (i.e. +61.0°C per sensor, space separated)
+	 *
+	 * @param line the line, with the '\n' added at the end
+	 * @param temps temperature of every sensor
+	 */
+	void formatSample(std::string& line, std::span<const double> temps) {
+		char reading[48];
+		for (std::size_t sensor = 0; sensor < temps.size(); sensor++) {
+			//Sensors report millidegrees, so three decimals keep every reading exact
+			int decimals = std::round(temps[sensor] * 10.0) / 10.0 == temps[sensor] ? 1 : 3;
+			std::snprintf(reading, sizeof(reading), "%s%+.*f°C", sensor > 0 ? " " : "", decimals, temps[sensor]);
+			line += reading;
+		}
+		line += '\n';
+	}
+}
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Loop of the sampling thread: reads every sensor on each tick of the
+ * interval until keepRunning is cleared or maxSamples are taken
+ *
+ * @param keepRunning cleared (i.e. by a signal handler) to stop
+ */
+void LiveSampler::SampleLoop(const std::atomic<bool>& keepRunning) {
+	std::vector<double> temps(ring.GetRowSize());
+	std::chrono::seconds interval(intervalSeconds);
+	std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+
+	while (keepRunning && !analysisFailed && (maxSamples == 0 || numSamples < maxSamples)) {
+		sensors.Sample(temps);
+		if (!ring.TryPush(temps)) {
+			numDropped++;
+		}
+		numSamples++;
+
+		//Ticks missed while stalled are skipped rather than sampled late
+		next += interval;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		while (next <= now) {
+			next += interval;
+		}
+		if (maxSamples != 0 && numSamples >= maxSamples) {
+			break;
+		}
+
+		//Sleep in short slices to notice keepRunning being cleared
+		while (keepRunning && !analysisFailed && std::chrono::steady_clock::now() < next) {
+			std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(next - std::chrono::steady_clock::now(),
+				std::chrono::milliseconds(100)));
+		}
+	}
+	samplingDone.store(true, std::memory_order_release);
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Sets up sampling into a log
+ *
+ * @param sensors sensors to read
+ * @param logName text log to write; the reports are named after it
+ * @param intervalSeconds time between two samples (at least 1)
+ * @param maxSamples samples to take before stopping, 0 for no limit
+ */
+LiveSampler::LiveSampler(SensorSampler& sensors, const std::string& logName, int intervalSeconds, uint64_t maxSamples)
+	: sensors(sensors), logName(logName), intervalSeconds(intervalSeconds > 0 ? intervalSeconds : 1), maxSamples(maxSamples),
+	ring(sensors.GetNumSensors(), RING_ROWS) {
+}
+
+/**
+ * Samples and analyses until keepRunning is cleared or maxSamples are
+ * taken, then writes the last reports
+ *
+ * @param keepRunning cleared (i.e. by a signal handler) to stop
+ *
+ * @return false if the log or a report could not be written
+ */
+bool LiveSampler::Run(const std::atomic<bool>& keepRunning) {
+	std::ofstream logOutput(logName, std::ios::binary | std::ios::trunc);
+	if (!logOutput) {
+		return false;
+	}
+	LogFollower analysis(logName, intervalSeconds);
+
+	std::thread samplingThread(&LiveSampler::SampleLoop, this, std::cref(keepRunning));
+	std::vector<double> temps(ring.GetRowSize());
+	std::string lines;
+	int numLogged = 0;
+	bool succeeded = true;
+	while (true) {
+		//Checked before draining, so nothing pushed before the last sample is missed
+		bool done = samplingDone.load(std::memory_order_acquire);
+		lines.clear();
+		bool popped = false;
+		while (ring.TryPop(temps)) {
+			//Timed by its line in the log, as a later run over the log will see it
+			analysis.AddReading(numLogged * intervalSeconds, temps);
+			formatSample(lines, temps);
+			numLogged++;
+			popped = true;
+		}
+
+		if (popped) {
+			logOutput << lines;
+			logOutput.flush();
+			if (!logOutput || !analysis.FlushReports()) {
+				succeeded = false;
+				analysisFailed = true;
+				break;
+			}
+		}
+		if (done) {
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MILLISECONDS));
+	}
+	samplingThread.join();
+	return succeeded;
+}
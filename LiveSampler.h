@@ -0,0 +1,84 @@
+/**
+ * The Live Sampler replaces the script that scraped the sensors into a text
+ * log for this tool to read. A sampling thread reads every sensor at a
+ * fixed interval and pushes each sample into an SPSC ring buffer. The
+ * calling thread pops the samples and feeds them to the same
+ * incremental interpolation and least squares stages --follow uses (one
+ * new interpolation per sensor and sample, running least squares sums),
+ * keeping the per-core reports up to date. It also appends each sample to
+ * a text log in the format parse_raw_temps reads, so the run can be
+ * analysed again later.
+ *
+ * Writing the reports never delays a sample: if the analysis falls so far
+ * behind that the ring buffer fills up, new samples are dropped and
+ * counted instead. Like the text log, the analysis places the n-th sample
+ * it receives at n intervals, so a dropped sample or a tick skipped while
+ * stalled shortens both the same way and the reports always match those of
+ * the log analysed again.
+ */
+#ifndef LIVE_SAMPLER_H_INCLUDED
+#define LIVE_SAMPLER_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SensorSampler.h"
+#include "SpscRingBuffer.h"
+
+class LiveSampler
+{
+private:
+
+	static constexpr std::size_t RING_ROWS = 4096; //!< Samples the ring buffer holds
+	static constexpr int POLL_MILLISECONDS = 20; //!< How long the consumer sleeps when the ring buffer is empty
+
+	SensorSampler& sensors; //!< Sensors to read
+	std::string logName; //!< Text log written, and the name the reports are given
+	int intervalSeconds; //!< Time between two samples
+	uint64_t maxSamples; //!< Samples to take before stopping, 0 for no limit
+
+	SpscRingBuffer<double> ring; //!< Samples on their way to the analysis, one temp per sensor
+	std::atomic<bool> samplingDone = false; //!< Set by the sampling thread once it has pushed its last sample
+	std::atomic<bool> analysisFailed = false; //!< Set by the consumer to stop the sampling thread
+	std::atomic<uint64_t> numSamples = 0; //!< Samples taken
+	std::atomic<uint64_t> numDropped = 0; //!< Samples dropped because the ring buffer was full
+
+	/**
+	 * Loop of the sampling thread: reads every sensor on each tick of the
+	 * interval until keepRunning is cleared or maxSamples are taken
+	 *
+	 * @param keepRunning cleared (i.e. by a signal handler) to stop
+	 */
+	void SampleLoop(const std::atomic<bool>& keepRunning);
+
+public:
+
+	/**
+	 * Sets up sampling into a log
+	 *
+	 * @param sensors sensors to read
+	 * @param logName text log to write; the reports are named after it
+	 * @param intervalSeconds time between two samples (at least 1)
+	 * @param maxSamples samples to take before stopping, 0 for no limit
+	 */
+	LiveSampler(SensorSampler& sensors, const std::string& logName, int intervalSeconds = 1, uint64_t maxSamples = 0);
+
+	LiveSampler(const LiveSampler&) = delete;
+	LiveSampler& operator=(const LiveSampler&) = delete;
+
+	/**
+	 * Samples and analyses until keepRunning is cleared or maxSamples are
+	 * taken, then writes the last reports
+	 *
+	 * @param keepRunning cleared (i.e. by a signal handler) to stop
+	 *
+	 * @return false if the log or a report could not be written
+	 */
+	bool Run(const std::atomic<bool>& keepRunning);
+
+	uint64_t GetNumSamples() const { return numSamples; }
+	uint64_t GetNumDropped() const { return numDropped; }
+};
+#endif
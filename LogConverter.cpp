@@ -0,0 +1,70 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <filesystem>
+
+#include "MappedTempParser.h"
+#include "DataPreProcessor.h"
+#include "BinaryLog.h"
+
+using namespace std;
+
+// Converts text temperature logs into binary logs (see BinaryLog.h), which
+// cpuTemps recognises and loads without parsing. Each log.txt becomes
+// log.bin next to it, so the reports keep the same names.
+
+// Names the binary log of a text log: the same name with a .bin extension
+string binaryLogName(const string& inputFileName) {
+    filesystem::path path(inputFileName);
+    path.replace_extension(".bin");
+    return path.string();
+}
+
+// Converts one log and prints the size saved. Returns the program exit code.
+int convertLog(const string& inputFileName) {
+    MappedTempParser input_temps(inputFileName);
+    if (!input_temps.IsOpen()) {
+        cout << "ERROR: " << inputFileName << " could not be opened" << "\n";
+        return 2;
+    }
+    if (BinaryLog::HasMagic(input_temps.Contents())) {
+        cout << "ERROR: " << inputFileName << " is already a binary log" << "\n";
+        return 3;
+    }
+    string outputFileName = binaryLogName(inputFileName);
+    if (outputFileName == inputFileName) {
+        cout << "ERROR: " << inputFileName << " would be overwritten by its binary log" << "\n";
+        return 3;
+    }
+
+    DataPreProcessor processedData(input_temps.Contents());
+    if (!BinaryLog::Write(outputFileName, processedData)) {
+        cout << "ERROR: " << inputFileName << " has readings with more than three decimals, "
+             << "or " << outputFileName << " could not be written" << "\n";
+        return 3;
+    }
+
+    std::error_code error;
+    uintmax_t binarySize = filesystem::file_size(outputFileName, error);
+    size_t textSize = input_temps.Contents().size();
+    cout << inputFileName << " -> " << outputFileName << ": " << textSize << " -> " << binarySize << " bytes ("
+         << fixed << setprecision(1) << (textSize > 0 ? 100.0 * binarySize / textSize : 0.0) << "%)" << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " input_file_name..." << "\n";
+        return 1;
+    }
+
+    int exitCode = 0;
+    for (int i = 1; i < argc; i++) {
+        int result = convertLog(argv[i]);
+        if (result != 0) {
+            exitCode = result;
+        }
+    }
+    return exitCode;
+}
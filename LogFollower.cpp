@@ -0,0 +1,295 @@
+#include "LogFollower.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedTempParser.h"
+#include "ReportWriter.h"
+
+namespace {
+	/**
+	 * Writes all of text at an offset of a file
+	 *
+	 * @param fd file to write
+	 * @param text bytes to write
+	 * @param offset where in the file to write them
+	 *
+	 * @return false if the write failed
+	 */
+	bool writeAt(int fd, std::string_view text, off_t offset) {
+		while (!text.empty()) {
+			ssize_t written = pwrite(fd, text.data(), text.size(), offset);
+			if (written < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return false;
+			}
+			text.remove_prefix(written);
+			offset += written;
+		}
+		return true;
+	}
+}
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Forgets everything consumed so far and truncates the reports
+ * (used when the log is replaced or truncated)
+ */
+void LogFollower::Reset() {
+	CloseOutputs();
+	inputOffset = 0;
+	numCores = 0;
+	numReadings = 0;
+	lastTime = 0;
+	lastTemps.clear();
+	coreSamples.clear();
+	pendingLines.clear();
+}
+
+/**
+ * Opens (and empties) the report of every core
+ *
+ * @return false if a report could not be opened
+ */
+bool LogFollower::OpenOutputs() {
+	for (int core = 0; core < numCores; core++) {
+		int fd = open(coreReportName(inputFileName, core).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			CloseOutputs();
+			return false;
+		}
+		outputFds.push_back(fd);
+		leastSquaresOffsets.push_back(0);
+	}
+	return true;
+}
+
+/**
+ * Closes the reports of every core
+ */
+void LogFollower::CloseOutputs() {
+	for (int fd : outputFds) {
+		close(fd);
+	}
+	outputFds.clear();
+	leastSquaresOffsets.clear();
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Creates a follower for a log
+ *
+ * @param inputFileName log to follow
+ * @param stepSize time-step in seconds between lines
+ */
+LogFollower::LogFollower(const std::string& inputFileName, int stepSize)
+	: inputFileName(inputFileName), stepSize(stepSize) {
+}
+
+/**
+ * Closes the log and the reports
+ */
+LogFollower::~LogFollower() {
+	CloseOutputs();
+	if (inputFd >= 0) {
+		close(inputFd);
+	}
+}
+
+/**
+ * Reads every complete line appended since the last call and brings the
+ * reports up to date. A trailing line without '\n' is left for later.
+ * The first call processes the whole existing log.
+ *
+ * @return false if the log could not be read or a report written
+ */
+bool LogFollower::Update() {
+	if (inputFd < 0) {
+		inputFd = open(inputFileName.c_str(), O_RDONLY | O_CLOEXEC);
+		if (inputFd < 0) {
+			return false;
+		}
+	}
+
+	struct stat fileInfo;
+	if (fstat(inputFd, &fileInfo) != 0) {
+		return false;
+	}
+	if (fileInfo.st_size < inputOffset) {
+		Reset();
+	}
+
+	if (readBuffer.size() < READ_CHUNK) {
+		readBuffer.resize(READ_CHUNK);
+	}
+
+	//carried holds the start of a line whose '\n' has not been read yet
+	size_t carried = 0;
+	while (true) {
+		ssize_t numRead = pread(inputFd, readBuffer.data() + carried, readBuffer.size() - carried, inputOffset + carried);
+		if (numRead < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		if (numRead == 0) {
+			break;
+		}
+
+		size_t filled = carried + numRead;
+		const char* lastNewline = static_cast<const char*>(memrchr(readBuffer.data(), '\n', filled));
+		if (lastNewline == nullptr) {
+			carried = filled;
+			if (carried == readBuffer.size()) {
+				readBuffer.resize(readBuffer.size() * 2);
+			}
+			continue;
+		}
+
+		size_t complete = lastNewline - readBuffer.data() + 1;
+		MappedTempParser::ForEachReadingIn(std::string_view(readBuffer.data(), complete), numReadings * stepSize,
+			stepSize, lineReadings, [this](int time, const std::vector<double>& temps) {
+				AddReading(time, temps);
+			});
+		inputOffset += complete;
+
+		carried = filled - complete;
+		std::memmove(readBuffer.data(), readBuffer.data() + complete, carried);
+
+		//Write after every chunk so pending lines stay bounded
+		if (!FlushReports()) {
+			return false;
+		}
+	}
+	return FlushReports();
+}
+
+/**
+ * Waits for the log to change (with inotify) and calls Update after every
+ * change, until keepRunning is cleared or the log is deleted or moved
+ *
+ * @param keepRunning cleared (i.e. by a signal handler) to stop following
+ *
+ * @return false if watching or updating failed
+ */
+bool LogFollower::Follow(const std::atomic<bool>& keepRunning) {
+	int watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watchFd < 0) {
+		return false;
+	}
+	if (inotify_add_watch(watchFd, inputFileName.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+		close(watchFd);
+		return false;
+	}
+
+	//Catch anything appended between the last Update and the watch starting
+	bool succeeded = Update();
+
+	alignas(struct inotify_event) char events[4096];
+	while (succeeded && keepRunning) {
+		struct pollfd watch = { watchFd, POLLIN, 0 };
+		//Wake up now and then to notice keepRunning being cleared
+		int ready = poll(&watch, 1, 500);
+		if (ready <= 0) {
+			if (ready < 0 && errno != EINTR) {
+				succeeded = false;
+			}
+			continue;
+		}
+
+		ssize_t numRead = read(watchFd, events, sizeof(events));
+		bool logGone = false;
+		for (char* pos = events; numRead > 0 && pos < events + numRead; ) {
+			const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(pos);
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+				logGone = true;
+			}
+			pos += sizeof(struct inotify_event) + event->len;
+		}
+
+		succeeded = Update();
+		if (logGone) {
+			break;
+		}
+	}
+
+	close(watchFd);
+	return succeeded;
+}
+
+/**
+ * Adds one line of the log: new interpolations and least squares samples.
+ * Also used for readings that never were in a log (see LiveSampler).
+ *
+ * @param time time of the line
+ * @param temps readings of the line
+ */
+void LogFollower::AddReading(int time, const std::vector<double>& temps) {
+	if (numReadings == 0) {
+		numCores = temps.size();
+		lastTemps.assign(numCores, 0.0);
+		coreSamples.assign(numCores, LeastSquaresAccumulator());
+		pendingLines.resize(numCores);
+	}
+
+	for (int core = 0; core < numCores; core++) {
+		//Short rows leave the missing cores at 0, like DataPreProcessor
+		double temp = core < temps.size() ? temps[core] : 0.0;
+		if (numReadings > 0) {
+			SlopeAndIntercept segment = interpolationCalculator.CalculateSegment(lastTime, time, lastTemps[core], temp);
+			pendingLines[core].AppendInterpolation(lastTime, time, numReadings - 1, segment.second, segment.first);
+		}
+		coreSamples[core].Add(time, temp);
+		lastTemps[core] = temp;
+	}
+	lastTime = time;
+	numReadings++;
+}
+
+/**
+ * Writes the pending interpolation lines and the refreshed least-squares
+ * line of every core
+ *
+ * @return false if a report could not be written
+ */
+bool LogFollower::FlushReports() {
+	if (numCores == 0) {
+		return true;
+	}
+	if (outputFds.empty() && !OpenOutputs()) {
+		return false;
+	}
+
+	ReportFormatter leastSquaresLine;
+	for (int core = 0; core < numCores; core++) {
+		//New interpolations go where the old least-squares line was
+		std::string_view newLines = pendingLines[core].View();
+		if (!writeAt(outputFds[core], newLines, leastSquaresOffsets[core])) {
+			return false;
+		}
+		leastSquaresOffsets[core] += newLines.size();
+		pendingLines[core].Clear();
+
+		SlopeAndIntercept coreSquareApprox = leastSquareCalculator.Calculate(coreSamples[core]);
+		leastSquaresLine.Clear();
+		leastSquaresLine.AppendLeastSquares(0, lastTime, coreSquareApprox.second, coreSquareApprox.first);
+		std::string_view line = leastSquaresLine.View();
+		if (!writeAt(outputFds[core], line, leastSquaresOffsets[core])
+			|| ftruncate(outputFds[core], leastSquaresOffsets[core] + line.size()) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,124 @@
+/**
+ * The Log Follower class keeps the per-core reports of a log up to date
+ * while a collector keeps appending to it. Only the lines added since the
+ * last look are parsed: each one adds one interpolation per core and is
+ * folded into that core's least squares running sums. The new
+ * interpolation lines are written over the old least-squares line of each
+ * report, followed by the refreshed least-squares line, so reports are
+ * never rewritten from the start.
+ */
+#ifndef LOG_FOLLOWER_H_INCLUDED
+#define LOG_FOLLOWER_H_INCLUDED
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "LeastSquaresAccumulator.h"
+#include "LeastSquaresApproximation.h"
+#include "PiecewiseLinearInterpolation.h"
+#include "ReportFormatter.h"
+
+class LogFollower
+{
+private:
+
+	static constexpr size_t READ_CHUNK = 1 << 20; //!< Bytes of the log read at a time
+
+	std::string inputFileName; //!< Log being followed
+	int stepSize; //!< Time-step in seconds between lines
+	int inputFd = -1; //!< Open descriptor of the log
+	off_t inputOffset = 0; //!< Bytes of the log consumed (always ends on a complete line)
+
+	int numCores = 0; //!< Number of cores (taken from the first line, 0 until then)
+	int numReadings = 0; //!< Lines consumed so far
+	int lastTime = 0; //!< Time of the last line consumed
+	std::vector<double> lastTemps = {}; //!< Temps of the last line consumed
+
+	std::vector<LeastSquaresAccumulator> coreSamples = {}; //!< Least squares running sums of every core
+	std::vector<ReportFormatter> pendingLines = {}; //!< Interpolation lines of every core not yet written
+	std::vector<int> outputFds = {}; //!< Open descriptor of every core report
+	std::vector<off_t> leastSquaresOffsets = {}; //!< Where the least-squares line starts in every core report
+
+	std::string readBuffer = ""; //!< Storage for bytes read from the log
+	std::vector<double> lineReadings = {}; //!< Storage for the readings of one line
+	PiecewiseLinearInterpolation interpolationCalculator;
+	LeastSquaresApproximation leastSquareCalculator;
+
+	/**
+	 * Forgets everything consumed so far and truncates the reports
+	 * (used when the log is replaced or truncated)
+	 */
+	void Reset();
+
+	/**
+	 * Opens (and empties) the report of every core
+	 *
+	 * @return false if a report could not be opened
+	 */
+	bool OpenOutputs();
+
+	/**
+	 * Closes the reports of every core
+	 */
+	void CloseOutputs();
+
+public:
+
+	/**
+	 * Creates a follower for a log
+	 *
+	 * @param inputFileName log to follow
+	 * @param stepSize time-step in seconds between lines
+	 */
+	LogFollower(const std::string& inputFileName, int stepSize = 30);
+
+	/**
+	 * Closes the log and the reports
+	 */
+	~LogFollower();
+
+	LogFollower(const LogFollower&) = delete;
+	LogFollower& operator=(const LogFollower&) = delete;
+
+	/**
+	 * Reads every complete line appended since the last call and brings the
+	 * reports up to date. A trailing line without '\n' is left for later.
+	 * The first call processes the whole existing log.
+	 *
+	 * @return false if the log could not be read or a report written
+	 */
+	bool Update();
+
+	/**
+	 * Waits for the log to change (with inotify) and calls Update after every
+	 * change, until keepRunning is cleared or the log is deleted or moved
+	 *
+	 * @param keepRunning cleared (i.e. by a signal handler) to stop following
+	 *
+	 * @return false if watching or updating failed
+	 */
+	bool Follow(const std::atomic<bool>& keepRunning);
+
+	/**
+	 * Adds one line of the log: new interpolations and least squares samples.
+	 * Also used for readings that never were in a log (see LiveSampler).
+	 *
+	 * @param time time of the line
+	 * @param temps readings of the line
+	 */
+	void AddReading(int time, const std::vector<double>& temps);
+
+	/**
+	 * Writes the pending interpolation lines and the refreshed least-squares
+	 * line of every core
+	 *
+	 * @return false if a report could not be written
+	 */
+	bool FlushReports();
+
+	int GetNumReadings() const { return numReadings; }
+};
+#endif
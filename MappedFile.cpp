@@ -0,0 +1,47 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Maps the provided file into memory for reading
+ *
+ * @param fileName path of the file to map
+ */
+MappedFile::MappedFile(const std::string& fileName) {
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat fileInfo;
+	if (fstat(fd, &fileInfo) == 0) {
+		length = fileInfo.st_size;
+		opened = true;
+	}
+
+	//An empty file cannot be mapped, but is still a valid (empty) file
+	if (opened && length > 0) {
+		void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED) {
+			opened = false;
+			length = 0;
+		}
+		else {
+			madvise(mapped, length, MADV_SEQUENTIAL);
+			data = static_cast<const char*>(mapped);
+		}
+	}
+	close(fd);
+}
+
+/**
+ * Unmaps the file
+ */
+MappedFile::~MappedFile() {
+	if (data != nullptr) {
+		munmap(const_cast<char*>(data), length);
+	}
+}
@@ -0,0 +1,51 @@
+/**
+ * The Mapped File class maps a whole file read-only into memory and
+ * unmaps it when destroyed.
+ */
+#ifndef MAPPED_FILE_H_INCLUDED
+#define MAPPED_FILE_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class MappedFile
+{
+private:
+
+	const char* data = nullptr; //!< Start of the mapped file (nullptr if empty or not opened)
+	size_t length = 0; //!< Number of bytes in the mapped file
+	bool opened = false; //!< Whether the file could be opened
+
+public:
+
+	/**
+	 * Maps the provided file into memory for reading
+	 *
+	 * @param fileName path of the file to map
+	 */
+	MappedFile(const std::string& fileName);
+
+	/**
+	 * Unmaps the file
+	 */
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	 * Reports if the file was opened and mapped
+	 *
+	 * @return false if the file could not be opened
+	 */
+	bool IsOpen() const { return opened; }
+
+	/**
+	 * Provides the raw bytes of the mapped file
+	 *
+	 * @return a view over the whole file
+	 */
+	std::string_view Contents() const { return std::string_view(data == nullptr ? "" : data, length); }
+};
+#endif
@@ -0,0 +1,73 @@
+#include "MappedTempParser.h"
+
+#include <charconv>
+#include <stdexcept>
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Reads one temperature token (i.e. +61.0°C) starting at pos. The leading
+ * '+' and anything after the number (the °C) are skipped.
+ *
+ * @param pos first character of the token
+ * @param end end of the line the token lives in
+ * @param value updated with the parsed temperature
+ *
+ * @return pointer to the first character after the token
+ *
+ * @throws std::invalid_argument if the token does not start with a number (same as stod)
+ */
+const char* MappedTempParser::ParseReading(const char* pos, const char* end, double& value) {
+	//from_chars does not accept a leading plus sign
+	const char* numberStart = pos;
+	if (numberStart < end && *numberStart == '+') {
+		numberStart++;
+	}
+
+	std::from_chars_result result = std::from_chars(numberStart, end, value);
+	if (result.ec == std::errc::invalid_argument) {
+		throw std::invalid_argument("stod");
+	}
+	if (result.ec == std::errc::result_out_of_range) {
+		throw std::out_of_range("stod");
+	}
+
+	//Skip the unit decoration up to the next separator
+	pos = result.ptr;
+	while (pos < end && !IsSeparator(*pos)) {
+		pos++;
+	}
+	return pos;
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Maps the provided file into memory for reading
+ *
+ * @param fileName path of the log to map
+ */
+MappedTempParser::MappedTempParser(const std::string& fileName) : file(fileName) {
+}
+
+/**
+ * Counts the lines ForEachReadingIn would visit
+ *
+ * @param text lines to count (a last line without '\n' still counts)
+ *
+ * @return the number of lines
+ */
+std::size_t MappedTempParser::CountLines(std::string_view text) {
+	const char* pos = text.data();
+	const char* textEnd = text.data() + text.size();
+	std::size_t numLines = 0;
+	while (pos < textEnd) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', textEnd - pos));
+		numLines++;
+		if (lineEnd == nullptr) {
+			break;
+		}
+		pos = lineEnd + 1;
+	}
+	return numLines;
+}
@@ -0,0 +1,194 @@
+/**
+ * The Mapped Temp Parser class memory-maps a temperature log and scans
+ * it in place. It produces the same readings as parse_raw_temps without
+ * building a string or a vector for every line or token.
+ */
+#ifndef MAPPED_TEMP_PARSER_H_INCLUDED
+#define MAPPED_TEMP_PARSER_H_INCLUDED
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <utility>
+
+#include "MappedFile.h"
+
+using CoreTempReading = std::pair<int, std::vector<double>>;
+
+class MappedTempParser
+{
+private:
+
+	MappedFile file; //!< The mapped log
+
+	std::vector<double> lineReadings = {}; //!< Reused storage for the readings of the current line
+
+	/**
+	 * Reads one temperature token (i.e. +61.0°C) starting at pos. The leading
+	 * '+' and anything after the number (the °C) are skipped.
+	 *
+	 * @param pos first character of the token
+	 * @param end end of the line the token lives in
+	 * @param value updated with the parsed temperature
+	 *
+	 * @return pointer to the first character after the token
+	 *
+	 * @throws std::invalid_argument if the token does not start with a number (same as stod)
+	 */
+	static const char* ParseReading(const char* pos, const char* end, double& value);
+
+	/**
+	 * Checks for the same whitespace that separates tokens in an istream
+	 *
+	 * @param c character to check
+	 *
+	 * @return true if c separates tokens
+	 */
+	static bool IsSeparator(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+public:
+
+	/**
+	 * Maps the provided file into memory for reading
+	 *
+	 * @param fileName path of the log to map
+	 */
+	MappedTempParser(const std::string& fileName);
+
+	/**
+	 * Reports if the file was opened and mapped
+	 *
+	 * @return false if the file could not be opened
+	 */
+	bool IsOpen() const { return file.IsOpen(); }
+
+	/**
+	 * Provides the raw bytes of the mapped file
+	 *
+	 * @return a view over the whole file
+	 */
+	std::string_view Contents() const { return file.Contents(); }
+
+	/**
+	 * Walks every line of the file and hands its time and readings to visit.
+	 * The readings container is reused from line to line, so nothing is
+	 * allocated once the widest line has been seen.
+	 *
+	 * @tparam Visitor callable as visit(int time, const std::vector<double>& temps)
+	 *
+	 * @param visit called once per line, in file order
+	 * @param step_size time-step in seconds
+	 *
+	 * @throws std::invalid_argument on a token that is not a number (same as stod)
+	 */
+	template<typename Visitor>
+	void ForEachReading(Visitor&& visit, int step_size = 30);
+
+	/**
+	 * Walks every line of a piece of log text. Used by ForEachReading, and by
+	 * readers that pick up a log a few lines at a time.
+	 *
+	 * @tparam Visitor callable as visit(int time, const std::vector<double>& temps)
+	 *
+	 * @param text lines to parse (a last line without '\n' is still parsed)
+	 * @param firstTime time of the first line of text
+	 * @param step_size time-step in seconds
+	 * @param lineReadings storage reused for the readings of each line
+	 * @param visit called once per line, in order
+	 *
+	 * @return the number of lines parsed
+	 *
+	 * @throws std::invalid_argument on a token that is not a number (same as stod)
+	 */
+	template<typename Visitor>
+	static int ForEachReadingIn(std::string_view text, int firstTime, int step_size,
+		std::vector<double>& lineReadings, Visitor&& visit);
+
+	/**
+	 * Counts the lines ForEachReadingIn would visit
+	 *
+	 * @param text lines to count (a last line without '\n' still counts)
+	 *
+	 * @return the number of lines
+	 */
+	static std::size_t CountLines(std::string_view text);
+
+	/**
+	 * Parses all core temps into a container, matching parse_raw_temps
+	 *
+	 * @tparam CoreTempReadingContainer type of container to use (it must implement
+	 *     emplace_back). A std::pmr container puts every line's readings in its
+	 *     own memory resource.
+	 *
+	 * @param step_size time-step in seconds
+	 * @param allocator allocator of the container (i.e. a PipelineArena for std::pmr containers)
+	 *
+	 * @return a container of 2-tuples (pairs) containing time step and core
+	 *         temperature readings
+	 */
+	template<typename CoreTempReadingContainer>
+	CoreTempReadingContainer ParseReadings(int step_size = 30,
+		const typename CoreTempReadingContainer::allocator_type& allocator = {});
+};
+
+template<typename Visitor>
+void MappedTempParser::ForEachReading(Visitor&& visit, int step_size) {
+	ForEachReadingIn(Contents(), 0, step_size, lineReadings, visit);
+}
+
+template<typename Visitor>
+int MappedTempParser::ForEachReadingIn(std::string_view text, int firstTime, int step_size,
+	std::vector<double>& lineReadings, Visitor&& visit) {
+	const char* pos = text.data();
+	const char* textEnd = text.data() + text.size();
+	int step = firstTime;
+	int numLines = 0;
+
+	while (pos < textEnd) {
+		//A last line without '\n' ends at the end of the text
+		const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', textEnd - pos));
+		const char* nextLine = lineEnd != nullptr ? lineEnd + 1 : textEnd;
+		if (lineEnd == nullptr) {
+			lineEnd = textEnd;
+		}
+
+		lineReadings.clear();
+		while (pos < lineEnd) {
+			if (IsSeparator(*pos)) {
+				pos++;
+				continue;
+			}
+			double reading;
+			pos = ParseReading(pos, lineEnd, reading);
+			lineReadings.push_back(reading);
+		}
+
+		visit(step, static_cast<const std::vector<double>&>(lineReadings));
+		step += step_size;
+		numLines++;
+		pos = nextLine;
+	}
+	return numLines;
+}
+
+template<typename CoreTempReadingContainer>
+CoreTempReadingContainer MappedTempParser::ParseReadings(int step_size,
+	const typename CoreTempReadingContainer::allocator_type& allocator) {
+	CoreTempReadingContainer allTheReadings(allocator);
+
+	//Count the lines first so the container is sized once
+	if constexpr (requires { allTheReadings.reserve(std::size_t()); }) {
+		allTheReadings.reserve(CountLines(Contents()));
+	}
+
+	//Piecewise so the readings are built with the container's allocator
+	ForEachReading([&allTheReadings](int time, const std::vector<double>& temps) {
+		allTheReadings.emplace_back(std::piecewise_construct, std::forward_as_tuple(time),
+			std::forward_as_tuple(temps.begin(), temps.end()));
+	}, step_size);
+	return allTheReadings;
+}
+#endif
@@ -0,0 +1,213 @@
+#include "ModelFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "LeastSquaresApproximation.h"
+#include "PiecewiseLinearInterpolation.h"
+#include "ReportFormatter.h"
+
+static_assert(sizeof(int) == sizeof(int32_t), "times are stored as int32");
+
+namespace {
+	/**
+	 * Rounds an offset up to the next multiple of alignment
+	 *
+	 * @param offset offset to round
+	 * @param alignment multiple to round to
+	 *
+	 * @return the rounded offset
+	 */
+	uint64_t alignUp(uint64_t offset, uint64_t alignment) {
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	/**
+	 * Writes bytes followed by zero padding up to the next column boundary
+	 *
+	 * @param out file being written
+	 * @param bytes start of the bytes to write
+	 * @param size number of bytes
+	 * @param paddedSize number of bytes including the padding
+	 */
+	void writePadded(std::ofstream& out, const void* bytes, uint64_t size, uint64_t paddedSize) {
+		static const char zeros[64] = {};
+		out.write(static_cast<const char*>(bytes), size);
+		for (uint64_t remaining = paddedSize - size; remaining > 0; ) {
+			uint64_t chunk = remaining < sizeof(zeros) ? remaining : sizeof(zeros);
+			out.write(zeros, chunk);
+			remaining -= chunk;
+		}
+	}
+}
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Checks the header and that every column lies inside the file
+ *
+ * @return false if the file is not a model file this code can read
+ */
+bool ModelFile::Validate() const {
+	std::string_view contents = file.Contents();
+	if (contents.size() < sizeof(ModelFileHeader)) {
+		return false;
+	}
+	const ModelFileHeader* candidate = reinterpret_cast<const ModelFileHeader*>(contents.data());
+	if (std::memcmp(candidate->magic, "CPUTMDL", 8) != 0 || candidate->version != MODEL_FILE_VERSION) {
+		return false;
+	}
+
+	uint64_t numSegments = candidate->numTimes > 1 ? candidate->numTimes - 1 : 0;
+	if (candidate->columnStride < numSegments) {
+		return false;
+	}
+
+	//Each column must be aligned and end inside the file. Counts are checked by dividing
+	//the room left, so a corrupt header cannot overflow a size and slip through.
+	auto fits = [&contents](uint64_t offset, uint64_t count, uint64_t elementSize) {
+		return offset % COLUMN_ALIGNMENT == 0 && offset <= contents.size() && count <= (contents.size() - offset) / elementSize;
+	};
+	auto coreColumnsFit = [&fits, &contents, candidate](uint64_t offset, uint64_t columnSize) {
+		return candidate->numCores == 0
+			|| (columnSize <= contents.size() / sizeof(double) / candidate->numCores
+				&& fits(offset, columnSize * candidate->numCores, sizeof(double)));
+	};
+	return fits(candidate->timesOffset, candidate->numTimes, sizeof(int32_t))
+		&& coreColumnsFit(candidate->slopesOffset, candidate->columnStride)
+		&& coreColumnsFit(candidate->interceptsOffset, candidate->columnStride)
+		&& fits(candidate->leastSquaresOffset, 2 * static_cast<uint64_t>(candidate->numCores), sizeof(double));
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Maps a model file for reading
+ *
+ * @param fileName path of the model file
+ */
+ModelFile::ModelFile(const std::string& fileName) : file(fileName) {
+	if (file.IsOpen() && Validate()) {
+		header = reinterpret_cast<const ModelFileHeader*>(file.Contents().data());
+	}
+}
+
+/**
+ * Fetches the times of the readings
+ *
+ * @return a view of the times
+ */
+std::span<const int> ModelFile::GetTimes() const {
+	return Column<int>(header->timesOffset, header->numTimes);
+}
+
+/**
+ * Fetches the interpolation slopes of one core
+ *
+ * @param coreNum specifies which core
+ *
+ * @return a view of the slopes, one per interpolation
+ */
+std::span<const double> ModelFile::GetSlopes(int coreNum) const {
+	uint64_t numSegments = header->numTimes > 1 ? header->numTimes - 1 : 0;
+	return Column<double>(header->slopesOffset + coreNum * header->columnStride * sizeof(double), numSegments);
+}
+
+/**
+ * Fetches the interpolation y-intercepts of one core
+ *
+ * @param coreNum specifies which core
+ *
+ * @return a view of the y-intercepts, one per interpolation
+ */
+std::span<const double> ModelFile::GetIntercepts(int coreNum) const {
+	uint64_t numSegments = header->numTimes > 1 ? header->numTimes - 1 : 0;
+	return Column<double>(header->interceptsOffset + coreNum * header->columnStride * sizeof(double), numSegments);
+}
+
+/**
+ * Fetches the least squares approximation of one core
+ *
+ * @param coreNum specifies which core
+ *
+ * @return a std::pair<double, double> that contains c1 and c0 respectively
+ */
+SlopeAndIntercept ModelFile::GetLeastSquares(int coreNum) const {
+	std::span<const double> coefficients = Column<double>(header->leastSquaresOffset, 2 * header->numCores);
+	return SlopeAndIntercept(coefficients[header->numCores + coreNum], coefficients[coreNum]);
+}
+
+/**
+ * Rebuilds the text report of one core, in the same layout cpuTemps writes
+ *
+ * @param coreNum specifies which core
+ *
+ * @return the report as it appears in <name>-core-N.txt
+ */
+std::string ModelFile::ToString(int coreNum) const {
+	PiecewiseLinearInterpolation interpolationCalculator;
+	LeastSquaresApproximation leastSquareCalculator;
+	std::span<const int> times = GetTimes();
+
+	ReportFormatter report;
+	interpolationCalculator.AppendTo(report, GetSlopes(coreNum), GetIntercepts(coreNum), times);
+	if (!times.empty()) {
+		leastSquareCalculator.AppendTo(report, GetLeastSquares(coreNum), times);
+	}
+	return report.Take();
+}
+
+/**
+ * Writes the models of a log to a model file
+ *
+ * @param fileName path of the model file to create
+ * @param times provides the times of the readings
+ * @param interpolations provides the interpolations of every core
+ * @param leastSquares provides the least squares approximation of every core
+ *
+ * @return false if the file could not be written
+ */
+bool ModelFile::Write(const std::string& fileName, std::span<const int> times,
+	const InterpolationTable& interpolations, std::span<const SlopeAndIntercept> leastSquares) {
+	uint64_t numCores = interpolations.GetNumCores();
+	uint64_t numSegments = interpolations.GetNumSegments();
+	uint64_t columnStride = alignUp(numSegments, COLUMN_ALIGNMENT / sizeof(double));
+	uint64_t coreColumnsSize = columnStride * numCores * sizeof(double);
+
+	ModelFileHeader header = {};
+	std::memcpy(header.magic, "CPUTMDL", 8);
+	header.version = MODEL_FILE_VERSION;
+	header.numCores = numCores;
+	header.numTimes = times.size();
+	header.columnStride = columnStride;
+	header.timesOffset = sizeof(ModelFileHeader);
+	header.slopesOffset = alignUp(header.timesOffset + times.size() * sizeof(int32_t), COLUMN_ALIGNMENT);
+	header.interceptsOffset = header.slopesOffset + coreColumnsSize;
+	header.leastSquaresOffset = header.interceptsOffset + coreColumnsSize;
+
+	std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		return false;
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	writePadded(out, times.data(), times.size() * sizeof(int32_t), header.slopesOffset - header.timesOffset);
+
+	for (uint64_t core = 0; core < numCores; core++) {
+		writePadded(out, interpolations.GetSlopes(core).data(), numSegments * sizeof(double), columnStride * sizeof(double));
+	}
+	for (uint64_t core = 0; core < numCores; core++) {
+		writePadded(out, interpolations.GetIntercepts(core).data(), numSegments * sizeof(double), columnStride * sizeof(double));
+	}
+
+	//Least squares c0 of every core, then c1 of every core
+	std::vector<double> leastSquaresColumns(2 * numCores, 0.0);
+	for (uint64_t core = 0; core < numCores && core < leastSquares.size(); core++) {
+		leastSquaresColumns[core] = leastSquares[core].second;
+		leastSquaresColumns[numCores + core] = leastSquares[core].first;
+	}
+	out.write(reinterpret_cast<const char*>(leastSquaresColumns.data()), leastSquaresColumns.size() * sizeof(double));
+
+	out.close();
+	return !out.fail();
+}
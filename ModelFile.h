@@ -0,0 +1,153 @@
+/**
+ * The Model File class reads and writes the fitted models of a log in a
+ * binary columnar format that can be memory-mapped and used in place:
+ *
+ *   header      ModelFileHeader (64 bytes)
+ *   times       int32 x numTimes
+ *   slopes      numCores columns of double x columnStride
+ *   intercepts  numCores columns of double x columnStride
+ *   lsq c0      double x numCores
+ *   lsq c1      double x numCores
+ *
+ * Every column starts on a 64 byte boundary; offsets in the header are
+ * from the start of the file. Values are stored in the machine's native
+ * (little-endian on x86) byte order. Each core column holds numTimes - 1
+ * interpolations.
+ */
+#ifndef MODEL_FILE_H_INCLUDED
+#define MODEL_FILE_H_INCLUDED
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+
+#include "InterpolationTable.h"
+#include "MappedFile.h"
+
+using SlopeAndIntercept = std::pair<double, double>;
+
+/**
+ * Fixed size header at the start of every model file
+ */
+struct ModelFileHeader
+{
+	char magic[8]; //!< "CPUTMDL" followed by a 0
+	uint32_t version; //!< Format version (MODEL_FILE_VERSION)
+	uint32_t numCores; //!< Number of core columns
+	uint64_t numTimes; //!< Number of readings
+	uint64_t columnStride; //!< Doubles between the starts of two core columns
+	uint64_t timesOffset; //!< Where the times column starts
+	uint64_t slopesOffset; //!< Where the first slope column starts
+	uint64_t interceptsOffset; //!< Where the first y-intercept column starts
+	uint64_t leastSquaresOffset; //!< Where the least squares c0 column starts (c1 follows it)
+};
+static_assert(sizeof(ModelFileHeader) == 64, "model file header must stay 64 bytes");
+
+class ModelFile
+{
+private:
+
+	static constexpr uint32_t MODEL_FILE_VERSION = 1; //!< Version written by this code
+	static constexpr uint64_t COLUMN_ALIGNMENT = 64; //!< Every column starts on a multiple of this
+
+	MappedFile file; //!< The mapped model file
+	const ModelFileHeader* header = nullptr; //!< Header of the file (nullptr if the file is not valid)
+
+	/**
+	 * Checks the header and that every column lies inside the file
+	 *
+	 * @return false if the file is not a model file this code can read
+	 */
+	bool Validate() const;
+
+	/**
+	 * Fetches a column of the file
+	 *
+	 * @tparam T type of the entries
+	 *
+	 * @param offset where the column starts
+	 * @param count number of entries
+	 *
+	 * @return a view over the column
+	 */
+	template<typename T>
+	std::span<const T> Column(uint64_t offset, uint64_t count) const {
+		return { reinterpret_cast<const T*>(file.Contents().data() + offset), count };
+	}
+
+public:
+
+	/**
+	 * Maps a model file for reading
+	 *
+	 * @param fileName path of the model file
+	 */
+	ModelFile(const std::string& fileName);
+
+	/**
+	 * Reports if the file was opened and is a valid model file
+	 *
+	 * @return false if the file could not be read as a model file
+	 */
+	bool IsValid() const { return header != nullptr; }
+
+	int GetNumCores() const { return header->numCores; }
+
+	/**
+	 * Fetches the times of the readings
+	 *
+	 * @return a view of the times
+	 */
+	std::span<const int> GetTimes() const;
+
+	/**
+	 * Fetches the interpolation slopes of one core
+	 *
+	 * @param coreNum specifies which core
+	 *
+	 * @return a view of the slopes, one per interpolation
+	 */
+	std::span<const double> GetSlopes(int coreNum) const;
+
+	/**
+	 * Fetches the interpolation y-intercepts of one core
+	 *
+	 * @param coreNum specifies which core
+	 *
+	 * @return a view of the y-intercepts, one per interpolation
+	 */
+	std::span<const double> GetIntercepts(int coreNum) const;
+
+	/**
+	 * Fetches the least squares approximation of one core
+	 *
+	 * @param coreNum specifies which core
+	 *
+	 * @return a std::pair<double, double> that contains c1 and c0 respectively
+	 */
+	SlopeAndIntercept GetLeastSquares(int coreNum) const;
+
+	/**
+	 * Rebuilds the text report of one core, in the same layout cpuTemps writes
+	 *
+	 * @param coreNum specifies which core
+	 *
+	 * @return the report as it appears in <name>-core-N.txt
+	 */
+	std::string ToString(int coreNum) const;
+
+	/**
+	 * Writes the models of a log to a model file
+	 *
+	 * @param fileName path of the model file to create
+	 * @param times provides the times of the readings
+	 * @param interpolations provides the interpolations of every core
+	 * @param leastSquares provides the least squares approximation of every core
+	 *
+	 * @return false if the file could not be written
+	 */
+	static bool Write(const std::string& fileName, std::span<const int> times,
+		const InterpolationTable& interpolations, std::span<const SlopeAndIntercept> leastSquares);
+};
+#endif
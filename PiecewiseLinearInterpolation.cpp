@@ -1,5 +1,9 @@
 #include "PiecewiseLinearInterpolation.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 //--------------------- Private Functions -----------------------//
 
 /**
@@ -34,6 +38,54 @@ const double PiecewiseLinearInterpolation::CalculateYIntercept(const int& x, con
 	return retVal;
 }
 
+/**
+ * Batch version of CalculateSlope and CalculateYIntercept for a run of
+ * consecutive interpolations of one core. Gives the same results as the
+ * scalar helpers.
+ *
+ * @param lowerTimes lower time reading of each interpolation
+ * @param timeSpans higher minus lower time reading of each interpolation
+ * @param temps temps of the core (count + 1 readings)
+ * @param slopes updated with the slope of each interpolation
+ * @param yIntercepts updated with the y-intercept of each interpolation
+ * @param count number of interpolations
+ */
+void PiecewiseLinearInterpolation::SegmentKernel(const double* lowerTimes, const double* timeSpans, const double* temps,
+	double* slopes, double* yIntercepts, std::size_t count) {
+	for (std::size_t i = 0; i < count; i++) {
+		double slope = (temps[i + 1] - temps[i]) / timeSpans[i];
+		slopes[i] = slope;
+		yIntercepts[i] = temps[i] - (slope * lowerTimes[i]);
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * Same as SegmentKernel, using AVX2 to work on 4 interpolations at a time.
+ * Only called when the CPU supports AVX2.
+ */
+__attribute__((target("avx2")))
+void PiecewiseLinearInterpolation::SegmentKernelAvx2(const double* lowerTimes, const double* timeSpans, const double* temps,
+	double* slopes, double* yIntercepts, std::size_t count) {
+	std::size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m256d temp0 = _mm256_loadu_pd(temps + i);
+		__m256d temp1 = _mm256_loadu_pd(temps + i + 1);
+		__m256d slope = _mm256_div_pd(_mm256_sub_pd(temp1, temp0), _mm256_loadu_pd(timeSpans + i));
+		//Multiply and subtract stay separate (no FMA) to match the scalar rounding
+		__m256d yIntercept = _mm256_sub_pd(temp0, _mm256_mul_pd(slope, _mm256_loadu_pd(lowerTimes + i)));
+		_mm256_storeu_pd(slopes + i, slope);
+		_mm256_storeu_pd(yIntercepts + i, yIntercept);
+	}
+	SegmentKernel(lowerTimes + i, timeSpans + i, temps + i, slopes + i, yIntercepts + i, count - i);
+}
+#else
+void PiecewiseLinearInterpolation::SegmentKernelAvx2(const double* lowerTimes, const double* timeSpans, const double* temps,
+	double* slopes, double* yIntercepts, std::size_t count) {
+	SegmentKernel(lowerTimes, timeSpans, temps, slopes, yIntercepts, count);
+}
+#endif
+
 //--------------------- Public Functions -----------------------//
 
 /**
@@ -45,11 +97,14 @@ const double PiecewiseLinearInterpolation::CalculateYIntercept(const int& x, con
  *
  * @pre Assumes temps[i] associates with times[i]
  */
-void PiecewiseLinearInterpolation::Calculate(std::vector<SlopeAndIntercept>& coreLineParts, const std::vector<int>& times, const std::vector<double>& temps) {
+void PiecewiseLinearInterpolation::Calculate(std::vector<SlopeAndIntercept>& coreLineParts, std::span<const int> times, std::span<const double> temps) {
 	int counterCap = 0;
 	if (times.size() == temps.size()) {
 		counterCap = temps.size();
 	}
+	if (counterCap > 1) {
+		coreLineParts.reserve(coreLineParts.size() + counterCap - 1);
+	}
 	for (int i = 0; i < counterCap - 1; i++) {
 		double slope;
 		double yIntercept;
@@ -67,6 +122,61 @@ void PiecewiseLinearInterpolation::Calculate(std::vector<SlopeAndIntercept>& cor
 	}
 }
 
+/**
+ * Calculates the slope and y-intercept of one interpolation
+ *
+ * @param time0 is the lower time reading
+ * @param time1 is the higher time reading
+ * @param temp0 is temp reading associated with lower time reading
+ * @param temp1 is temp reading associated with higher time reading
+ *
+ * @return a std::pair<double, double> that contains the slope and y-intercept respectively
+ */
+SlopeAndIntercept PiecewiseLinearInterpolation::CalculateSegment(int time0, int time1, double temp0, double temp1) {
+	double slope = CalculateSlope(time0, time1, temp0, temp1);
+	double yIntercept = CalculateYIntercept(time0, temp0, slope);
+	return SlopeAndIntercept(slope, yIntercept);
+}
+
+/**
+ * Calculates the slopes and y-intercepts of every core at once. The time
+ * differences are worked out once and shared by all cores, and each core
+ * runs through a SIMD kernel (AVX2 where the CPU has it).
+ *
+ * @param table resized and filled with one column of slopes and y-intercepts per core
+ * @param data provides the times and the temps of every core
+ */
+void PiecewiseLinearInterpolation::Calculate(InterpolationTable& table, const DataPreProcessor& data) {
+	std::span<const int> times = data.GetTimes();
+	std::size_t numSegments = times.size() > 1 ? times.size() - 1 : 0;
+	table.Resize(data.GetNumCores(), numSegments);
+
+	std::vector<double> lowerTimes(numSegments);
+	std::vector<double> timeSpans(numSegments);
+	for (std::size_t i = 0; i < numSegments; i++) {
+		lowerTimes[i] = times[i];
+		timeSpans[i] = times[i + 1] - times[i];
+	}
+
+#if defined(__x86_64__) || defined(__i386__)
+	bool useAvx2 = __builtin_cpu_supports("avx2");
+#else
+	bool useAvx2 = false;
+#endif
+
+	for (int core = 0; core < data.GetNumCores(); core++) {
+		const double* temps = data.GetCoreReadings(core).data();
+		double* slopes = table.GetSlopes(core).data();
+		double* yIntercepts = table.GetIntercepts(core).data();
+		if (useAvx2) {
+			SegmentKernelAvx2(lowerTimes.data(), timeSpans.data(), temps, slopes, yIntercepts, numSegments);
+		}
+		else {
+			SegmentKernel(lowerTimes.data(), timeSpans.data(), temps, slopes, yIntercepts, numSegments);
+		}
+	}
+}
+
 /**
  * Provides a formatted list of the piecewise interpolations for a core as a String
  * Each line follows a format akin to:
@@ -78,22 +188,49 @@ void PiecewiseLinearInterpolation::Calculate(std::vector<SlopeAndIntercept>& cor
  *
  * @return string to be used in output
  */
-const std::string PiecewiseLinearInterpolation::ToString(const std::vector<SlopeAndIntercept>& coreLineParts, const std::vector<int>& times) {
-	std::stringstream retVal;
+const std::string PiecewiseLinearInterpolation::ToString(const std::vector<SlopeAndIntercept>& coreLineParts, std::span<const int> times) {
+	ReportFormatter retVal;
+	AppendTo(retVal, coreLineParts, times);
+	return retVal.Take();
+}
+
+/**
+ * Appends the formatted list of the piecewise interpolations for a core
+ * to a report, using the same format as ToString
+ *
+ * @param report formatter to write the lines into
+ * @param coreLineParts provides the slope and y-intercept for each interpolation
+ * @param times provides the limits of the interpolation
+ */
+void PiecewiseLinearInterpolation::AppendTo(ReportFormatter& report, const std::vector<SlopeAndIntercept>& coreLineParts, std::span<const int> times) {
+	int countCap = times.size();
+	if (countCap > 1) {
+		report.Reserve(countCap - 1);
+	}
 
-	//Sets significant figs
-	retVal << std::setprecision(4) << std::fixed;
+	for (int i = 0; i < countCap - 1; i++) {
+		report.AppendInterpolation(times[i], times[i + 1], i, coreLineParts[i].second, coreLineParts[i].first);
+	}
+}
 
-	int spacing = 8;
+/**
+ * Appends the formatted list of the piecewise interpolations for a core,
+ * taking the slopes and y-intercepts from separate arrays
+ *
+ * @param report formatter to write the lines into
+ * @param slopes provides the slope of each interpolation
+ * @param yIntercepts provides the y-intercept of each interpolation
+ * @param times provides the limits of the interpolation
+ * @param firstIndex number of the first interpolation (non-zero when times is a later piece of a log)
+ */
+void PiecewiseLinearInterpolation::AppendTo(ReportFormatter& report, std::span<const double> slopes, std::span<const double> yIntercepts, std::span<const int> times,
+	std::size_t firstIndex) {
 	int countCap = times.size();
+	if (countCap > 1) {
+		report.Reserve(countCap - 1);
+	}
 
 	for (int i = 0; i < countCap - 1; i++) {
-		retVal << std::right << std::setfill(' ') << std::setw(spacing) << times[i] << " <= x <" 
-			   << std::right << std::setfill(' ') << std::setw(spacing) << times[i+1] << "; y_"
-			   << std::left  << std::setfill(' ') << std::setw(spacing) << i << " = "
-			   << std::right << std::setfill(' ') << std::setw(spacing + (spacing / 2)) << coreLineParts[i].second << " + "
-			   << std::right << std::setfill(' ') << std::setw(spacing + (spacing / 2)) << coreLineParts[i].first << "x; interpolation"
-			   << "\n";
+		report.AppendInterpolation(times[i], times[i + 1], firstIndex + i, yIntercepts[i], slopes[i]);
 	}
-	return retVal.str();
-}
\ No newline at end of file
+}
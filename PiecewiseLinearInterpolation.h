@@ -9,11 +9,14 @@
 #define PIECEWISE_LINEAR_INTERPOLATION_H_INCLUDED
 
 #include <string>
-#include <iomanip>
-#include <sstream>
+#include <span>
 #include <vector>
 #include <utility>
 
+#include "DataPreProcessor.h"
+#include "InterpolationTable.h"
+#include "ReportFormatter.h"
+
 using SlopeAndIntercept = std::pair<double, double>;
 
 class PiecewiseLinearInterpolation
@@ -44,6 +47,28 @@ private:
 	 */
 	const double CalculateYIntercept(const int& x, const double& y, const double& slope);
 
+	/**
+	 * Batch version of CalculateSlope and CalculateYIntercept for a run of
+	 * consecutive interpolations of one core. Gives the same results as the
+	 * scalar helpers.
+	 *
+	 * @param lowerTimes lower time reading of each interpolation
+	 * @param timeSpans higher minus lower time reading of each interpolation
+	 * @param temps temps of the core (count + 1 readings)
+	 * @param slopes updated with the slope of each interpolation
+	 * @param yIntercepts updated with the y-intercept of each interpolation
+	 * @param count number of interpolations
+	 */
+	static void SegmentKernel(const double* lowerTimes, const double* timeSpans, const double* temps,
+		double* slopes, double* yIntercepts, std::size_t count);
+
+	/**
+	 * Same as SegmentKernel, using AVX2 to work on 4 interpolations at a time.
+	 * Only called when the CPU supports AVX2.
+	 */
+	static void SegmentKernelAvx2(const double* lowerTimes, const double* timeSpans, const double* temps,
+		double* slopes, double* yIntercepts, std::size_t count);
+
 public:
 
 	/**
@@ -55,7 +80,29 @@ public:
 	 * 
 	 * @pre Assumes temps[i] associates with times[i]
 	 */
-	void Calculate(std::vector<SlopeAndIntercept>& coreLineParts, const std::vector<int>& times, const std::vector<double>& temps);
+	void Calculate(std::vector<SlopeAndIntercept>& coreLineParts, std::span<const int> times, std::span<const double> temps);
+
+	/**
+	 * Calculates the slope and y-intercept of one interpolation
+	 *
+	 * @param time0 is the lower time reading
+	 * @param time1 is the higher time reading
+	 * @param temp0 is temp reading associated with lower time reading
+	 * @param temp1 is temp reading associated with higher time reading
+	 *
+	 * @return a std::pair<double, double> that contains the slope and y-intercept respectively
+	 */
+	SlopeAndIntercept CalculateSegment(int time0, int time1, double temp0, double temp1);
+
+	/**
+	 * Calculates the slopes and y-intercepts of every core at once. The time
+	 * differences are worked out once and shared by all cores, and each core
+	 * runs through a SIMD kernel (AVX2 where the CPU has it).
+	 *
+	 * @param table resized and filled with one column of slopes and y-intercepts per core
+	 * @param data provides the times and the temps of every core
+	 */
+	void Calculate(InterpolationTable& table, const DataPreProcessor& data);
 
 	/**
 	 * Provides a formatted list of the piecewise interpolations for a core as a String
@@ -68,6 +115,29 @@ public:
 	 *
 	 * @return string to be used in output
 	 */
-	const std::string ToString(const std::vector<SlopeAndIntercept>& coreLineParts, const std::vector<int>& times);
+	const std::string ToString(const std::vector<SlopeAndIntercept>& coreLineParts, std::span<const int> times);
+
+	/**
+	 * Appends the formatted list of the piecewise interpolations for a core
+	 * to a report, using the same format as ToString
+	 *
+	 * @param report formatter to write the lines into
+	 * @param coreLineParts provides the slope and y-intercept for each interpolation
+	 * @param times provides the limits of the interpolation
+	 */
+	void AppendTo(ReportFormatter& report, const std::vector<SlopeAndIntercept>& coreLineParts, std::span<const int> times);
+
+	/**
+	 * Appends the formatted list of the piecewise interpolations for a core,
+	 * taking the slopes and y-intercepts from separate arrays
+	 *
+	 * @param report formatter to write the lines into
+	 * @param slopes provides the slope of each interpolation
+	 * @param yIntercepts provides the y-intercept of each interpolation
+	 * @param times provides the limits of the interpolation
+	 * @param firstIndex number of the first interpolation (non-zero when times is a later piece of a log)
+	 */
+	void AppendTo(ReportFormatter& report, std::span<const double> slopes, std::span<const double> yIntercepts, std::span<const int> times,
+		std::size_t firstIndex = 0);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "PipelineArena.h"
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Hands out memory from the arena
+ *
+ * @param bytes size of the request
+ * @param alignment alignment of the request
+ *
+ * @return pointer to the memory
+ */
+void* PipelineArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+	bytesUsed += bytes + alignment - 1;
+	return arena->allocate(bytes, alignment);
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Creates an arena with a first block of the given size
+ *
+ * @param initialCapacity size of the first block in bytes
+ */
+PipelineArena::PipelineArena(std::size_t initialCapacity)
+	: buffer(std::make_unique_for_overwrite<std::byte[]>(initialCapacity)), capacity(initialCapacity) {
+	arena.emplace(buffer.get(), capacity, std::pmr::new_delete_resource());
+}
+
+/**
+ * Frees everything handed out. If the last file needed more than one
+ * block, the block is regrown so the next file of that size fits in it.
+ *
+ * @pre nothing allocated from the arena is still in use
+ */
+void PipelineArena::Reset() {
+	//Dropping the resource frees the extra blocks it took from the heap
+	arena.reset();
+	if (bytesUsed > capacity) {
+		capacity = bytesUsed + bytesUsed / 4;
+		buffer.reset();
+		buffer = std::make_unique_for_overwrite<std::byte[]>(capacity);
+	}
+	bytesUsed = 0;
+	arena.emplace(buffer.get(), capacity, std::pmr::new_delete_resource());
+}
@@ -0,0 +1,90 @@
+/**
+ * The Pipeline Arena class is a bump-pointer memory resource for the data
+ * of one input file. Containers built on it (std::pmr containers, or the
+ * CacheAlignedAllocator) take their storage from one large block instead of
+ * making a heap allocation each; freeing is a no-op and everything is given
+ * back at once by Reset.
+ *
+ * The block grows to the most memory a file has needed, so after the first
+ * file of a batch a whole file usually fits in a single allocation.
+ *
+ * Not thread safe: each thread that processes files uses its own arena.
+ */
+#ifndef PIPELINE_ARENA_H_INCLUDED
+#define PIPELINE_ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+class PipelineArena : public std::pmr::memory_resource
+{
+private:
+
+	static constexpr std::size_t DEFAULT_CAPACITY = 1 << 20; //!< Size of the first block
+
+	std::unique_ptr<std::byte[]> buffer = nullptr; //!< The block handed out first
+	std::size_t capacity = 0; //!< Size of buffer
+	std::size_t bytesUsed = 0; //!< Bytes handed out since the last Reset
+	std::optional<std::pmr::monotonic_buffer_resource> arena; //!< Carves buffer up, then falls back to the heap
+
+	/**
+	 * Hands out memory from the arena
+	 *
+	 * @param bytes size of the request
+	 * @param alignment alignment of the request
+	 *
+	 * @return pointer to the memory
+	 */
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+	/**
+	 * Does nothing, memory is only given back by Reset
+	 */
+	void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+	/**
+	 * Arenas are only interchangeable with themselves
+	 *
+	 * @param other resource to compare with
+	 *
+	 * @return true if other is this arena
+	 */
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+
+	/**
+	 * Creates an arena with a first block of the given size
+	 *
+	 * @param initialCapacity size of the first block in bytes
+	 */
+	PipelineArena(std::size_t initialCapacity = DEFAULT_CAPACITY);
+
+	PipelineArena(const PipelineArena&) = delete;
+	PipelineArena& operator=(const PipelineArena&) = delete;
+
+	/**
+	 * Frees everything handed out. If the last file needed more than one
+	 * block, the block is regrown so the next file of that size fits in it.
+	 *
+	 * @pre nothing allocated from the arena is still in use
+	 */
+	void Reset();
+
+	/**
+	 * Reports how much has been handed out since the last Reset
+	 *
+	 * @return bytes handed out
+	 */
+	std::size_t GetBytesUsed() const { return bytesUsed; }
+
+	/**
+	 * Reports the size of the block the arena starts from
+	 *
+	 * @return bytes in the block
+	 */
+	std::size_t GetCapacity() const { return capacity; }
+};
+#endif
@@ -0,0 +1,246 @@
+#include "PipelineStats.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	/**
+	 * Kept just before every block handed out by operator new, so a free is
+	 * only counted when the allocation was counted too
+	 */
+	struct alignas(std::max_align_t) BlockHeader
+	{
+		std::size_t size; //!< Bytes requested
+		bool tracked; //!< Whether the allocation was counted
+	};
+
+	std::atomic<bool> trackingAllocations = false; //!< Whether operator new is counting
+	std::atomic<uint64_t> allocationCount = 0; //!< Allocations made while counting
+	std::atomic<uint64_t> allocatedBytes = 0; //!< Bytes requested while counting
+	std::atomic<int64_t> liveBytes = 0; //!< Bytes allocated while counting and not yet freed
+	std::atomic<int64_t> peakLiveBytes = 0; //!< Highest liveBytes seen
+
+	const char* STAGE_NAMES[] = { "parse", "interpolate", "fit", "format", "write" };
+
+	/**
+	 * Fetches the bytes kept in front of a block for its header
+	 *
+	 * @param alignment alignment of the block
+	 *
+	 * @return a multiple of alignment with room for a BlockHeader
+	 */
+	std::size_t headerBytes(std::size_t alignment) {
+		return alignment > sizeof(BlockHeader) ? alignment : sizeof(BlockHeader);
+	}
+
+	/**
+	 * Fills in the header of a new block and counts it if allocation
+	 * tracking is on
+	 *
+	 * @param base start of the memory from malloc
+	 * @param size bytes requested
+	 * @param alignment alignment of the block
+	 *
+	 * @return the block to hand out
+	 */
+	void* countAllocation(void* base, std::size_t size, std::size_t alignment) {
+		void* block = static_cast<char*>(base) + headerBytes(alignment);
+		BlockHeader* header = static_cast<BlockHeader*>(block) - 1;
+		header->size = size;
+		header->tracked = trackingAllocations.load(std::memory_order_relaxed);
+		if (header->tracked) {
+			allocationCount.fetch_add(1, std::memory_order_relaxed);
+			allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+			int64_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+			int64_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+			while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+			}
+		}
+		return block;
+	}
+
+	/**
+	 * Uncounts a block that was counted when it was allocated
+	 *
+	 * @param block the memory being freed (not nullptr)
+	 * @param alignment alignment the block was allocated with
+	 *
+	 * @return start of the memory to hand back to free
+	 */
+	void* countFree(void* block, std::size_t alignment) {
+		const BlockHeader* header = static_cast<const BlockHeader*>(block) - 1;
+		if (header->tracked) {
+			liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+		}
+		return static_cast<char*>(block) - headerBytes(alignment);
+	}
+
+	/**
+	 * Frees a block from the operator new matching alignment
+	 *
+	 * @param block the memory being freed (may be nullptr)
+	 * @param alignment alignment the block was allocated with
+	 */
+	void freeBlock(void* block, std::size_t alignment) {
+		if (block != nullptr) {
+			std::free(countFree(block, alignment));
+		}
+	}
+
+	/**
+	 * Appends "name": value, to a JSON object
+	 *
+	 * @param json text being built
+	 * @param name key of the member
+	 * @param value value of the member
+	 */
+	void appendMember(std::string& json, const char* name, uint64_t value) {
+		json += "\"";
+		json += name;
+		json += "\": ";
+		json += std::to_string(value);
+	}
+
+	/**
+	 * Appends "name": seconds, to a JSON object
+	 *
+	 * @param json text being built
+	 * @param name key of the member
+	 * @param seconds value of the member
+	 */
+	void appendSeconds(std::string& json, const char* name, double seconds) {
+		char number[32];
+		std::snprintf(number, sizeof(number), "%.6f", seconds);
+		json += "\"";
+		json += name;
+		json += "\": ";
+		json += number;
+	}
+}
+
+//Every heap allocation of the program goes through these, so allocations can
+//be counted while a PipelineStats is alive. The array and nothrow forms
+//forward to them. Each block carries a BlockHeader, so only blocks counted
+//when allocated are uncounted when freed.
+
+void* operator new(std::size_t size) {
+	void* base = std::malloc(headerBytes(alignof(std::max_align_t)) + size);
+	if (base == nullptr) {
+		throw std::bad_alloc();
+	}
+	return countAllocation(base, size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	//aligned_alloc wants a multiple of the alignment, which the header keeps too
+	std::size_t align = headerBytes(static_cast<std::size_t>(alignment));
+	void* base = std::aligned_alloc(align, align + (size + align - 1) / align * align);
+	if (base == nullptr) {
+		throw std::bad_alloc();
+	}
+	return countAllocation(base, size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* block) noexcept {
+	freeBlock(block, alignof(std::max_align_t));
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+	freeBlock(block, alignof(std::max_align_t));
+}
+
+void operator delete(void* block, std::align_val_t alignment) noexcept {
+	freeBlock(block, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* block, std::size_t, std::align_val_t alignment) noexcept {
+	freeBlock(block, static_cast<std::size_t>(alignment));
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Starts the run clock and begins counting heap allocations
+ */
+PipelineStats::PipelineStats() : start(std::chrono::steady_clock::now()) {
+	allocationCount = 0;
+	allocatedBytes = 0;
+	liveBytes = 0;
+	peakLiveBytes = 0;
+	trackingAllocations = true;
+}
+
+/**
+ * Stops counting heap allocations
+ */
+PipelineStats::~PipelineStats() {
+	trackingAllocations = false;
+}
+
+/**
+ * Adds time spent in a stage
+ *
+ * @param stage stage the time was spent in
+ * @param elapsed time spent
+ */
+void PipelineStats::AddStageTime(PipelineStage stage, std::chrono::steady_clock::duration elapsed) {
+	std::size_t index = static_cast<std::size_t>(stage);
+	stageNanoseconds[index].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+	stageCalls[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Records one processed input file
+ *
+ * @param fileBytes size of the input
+ * @param fileSamples readings in the input (lines x cores)
+ * @param fileSegments interpolations produced over all cores
+ */
+void PipelineStats::AddFile(uint64_t fileBytes, uint64_t fileSamples, uint64_t fileSegments) {
+	files.fetch_add(1, std::memory_order_relaxed);
+	bytesRead.fetch_add(fileBytes, std::memory_order_relaxed);
+	samples.fetch_add(fileSamples, std::memory_order_relaxed);
+	segments.fetch_add(fileSegments, std::memory_order_relaxed);
+}
+
+/**
+ * Formats everything collected so far as a JSON object
+ *
+ * @return the JSON summary, ending in a newline
+ */
+std::string PipelineStats::ToJson() const {
+	double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::string json = "{\n  ";
+	appendSeconds(json, "wall_seconds", wallSeconds);
+	json += ",\n  \"stages\": {";
+	for (std::size_t stage = 0; stage < NUM_STAGES; stage++) {
+		json += stage == 0 ? "\n    \"" : ",\n    \"";
+		json += STAGE_NAMES[stage];
+		json += "\": {";
+		appendSeconds(json, "seconds", stageNanoseconds[stage].load() / 1e9);
+		json += ", ";
+		appendMember(json, "calls", stageCalls[stage].load());
+		json += "}";
+	}
+	json += "\n  },\n  ";
+	appendMember(json, "files", files.load());
+	json += ",\n  ";
+	appendMember(json, "bytes_read", bytesRead.load());
+	json += ",\n  ";
+	appendMember(json, "bytes_written", bytesWritten.load());
+	json += ",\n  ";
+	appendMember(json, "samples", samples.load());
+	json += ",\n  ";
+	appendMember(json, "segments", segments.load());
+	json += ",\n  \"allocations\": {";
+	appendMember(json, "count", allocationCount.load());
+	json += ", ";
+	appendMember(json, "bytes", allocatedBytes.load());
+	json += ", ";
+	appendMember(json, "peak_live_bytes", peakLiveBytes.load());
+	json += "}\n}\n";
+	return json;
+}
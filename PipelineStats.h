@@ -0,0 +1,135 @@
+/**
+ * The Pipeline Stats class collects where a run spent its time: monotonic
+ * clock timings of every pipeline stage, bytes read and written, sample and
+ * segment counts, and heap allocation counts. Counters are atomics so
+ * several files or cores can report into one instance at once; stage times
+ * are summed across threads.
+ *
+ * Nothing is recorded unless a PipelineStats is handed to the pipeline, so
+ * a run without --stats only pays for a null pointer check per stage.
+ */
+#ifndef PIPELINE_STATS_H_INCLUDED
+#define PIPELINE_STATS_H_INCLUDED
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * Pipeline stages that are timed
+ */
+enum class PipelineStage
+{
+	Parse, //!< Parsing the log into the column store
+	Interpolate, //!< Piecewise linear interpolation of every core
+	Fit, //!< Least squares approximations
+	Format, //!< Formatting the reports
+	Write, //!< Writing the report and model files
+	Count //!< Number of stages
+};
+
+class PipelineStats
+{
+private:
+
+	static constexpr std::size_t NUM_STAGES = static_cast<std::size_t>(PipelineStage::Count); //!< Number of timed stages
+
+	std::array<std::atomic<uint64_t>, NUM_STAGES> stageNanoseconds = {}; //!< Time spent in every stage
+	std::array<std::atomic<uint64_t>, NUM_STAGES> stageCalls = {}; //!< Times every stage ran
+
+	std::atomic<uint64_t> files = 0; //!< Input files processed
+	std::atomic<uint64_t> bytesRead = 0; //!< Bytes of input parsed
+	std::atomic<uint64_t> bytesWritten = 0; //!< Bytes of reports and models written
+	std::atomic<uint64_t> samples = 0; //!< Temperature readings processed (lines x cores)
+	std::atomic<uint64_t> segments = 0; //!< Interpolations produced (over all cores)
+
+	std::chrono::steady_clock::time_point start; //!< When the run started
+
+public:
+
+	/**
+	 * Times one stage from construction to destruction and adds the result
+	 * to a PipelineStats. Does nothing when given no PipelineStats.
+	 */
+	class StageTimer
+	{
+	private:
+
+		PipelineStats* stats; //!< Where the time goes (may be nullptr)
+		PipelineStage stage; //!< Stage being timed
+		std::chrono::steady_clock::time_point stageStart; //!< When the stage started
+
+	public:
+
+		/**
+		 * Starts timing a stage
+		 *
+		 * @param stats collects the time, nothing is timed if nullptr
+		 * @param stage stage being timed
+		 */
+		StageTimer(PipelineStats* stats, PipelineStage stage) : stats(stats), stage(stage) {
+			if (stats != nullptr) {
+				stageStart = std::chrono::steady_clock::now();
+			}
+		}
+
+		/**
+		 * Stops timing and records the time
+		 */
+		~StageTimer() {
+			if (stats != nullptr) {
+				stats->AddStageTime(stage, std::chrono::steady_clock::now() - stageStart);
+			}
+		}
+
+		StageTimer(const StageTimer&) = delete;
+		StageTimer& operator=(const StageTimer&) = delete;
+	};
+
+	/**
+	 * Starts the run clock and begins counting heap allocations
+	 */
+	PipelineStats();
+
+	/**
+	 * Stops counting heap allocations
+	 */
+	~PipelineStats();
+
+	PipelineStats(const PipelineStats&) = delete;
+	PipelineStats& operator=(const PipelineStats&) = delete;
+
+	/**
+	 * Adds time spent in a stage
+	 *
+	 * @param stage stage the time was spent in
+	 * @param elapsed time spent
+	 */
+	void AddStageTime(PipelineStage stage, std::chrono::steady_clock::duration elapsed);
+
+	/**
+	 * Records one processed input file
+	 *
+	 * @param fileBytes size of the input
+	 * @param fileSamples readings in the input (lines x cores)
+	 * @param fileSegments interpolations produced over all cores
+	 */
+	void AddFile(uint64_t fileBytes, uint64_t fileSamples, uint64_t fileSegments);
+
+	/**
+	 * Records bytes written to a report or model file
+	 *
+	 * @param numBytes bytes written
+	 */
+	void AddBytesWritten(uint64_t numBytes) { bytesWritten.fetch_add(numBytes, std::memory_order_relaxed); }
+
+	/**
+	 * Formats everything collected so far as a JSON object
+	 *
+	 * @return the JSON summary, ending in a newline
+	 */
+	std::string ToJson() const;
+};
+#endif
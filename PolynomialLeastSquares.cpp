@@ -0,0 +1,101 @@
+#include "PolynomialLeastSquares.h"
+
+#include <algorithm>
+#include <cmath>
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Converts coefficients of a polynomial in s = (x - center) / scale into
+ * coefficients of the same polynomial in x
+ *
+ * @param scaled coefficients in s, lowest power first
+ * @param center shift that was applied to x
+ * @param scale divisor that was applied to x
+ *
+ * @return coefficients in x, lowest power first
+ */
+std::vector<double> PolynomialLeastSquares::Unscale(const std::vector<double>& scaled, double center, double scale) const {
+	std::vector<double> retVal(scaled.size(), 0.0);
+	//a_i ((x - center) / scale)^i expanded with the binomial theorem
+	for (int i = 0; i < scaled.size(); i++) {
+		double termScale = scaled[i] / std::pow(scale, i);
+		double binomial = 1.0;
+		for (int j = i; j >= 0; j--) {
+			retVal[j] += termScale * binomial * std::pow(-center, i - j);
+			binomial = binomial * j / (i - j + 1);
+		}
+	}
+	return retVal;
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Calculates the coefficients c0..ck of the polynomial least squares approximation
+ *
+ * @param times provides list of the times
+ * @param temps provides list of the temps of the target core
+ *
+ * @return the coefficients, lowest power first (empty if there are fewer
+ *         than degree + 1 distinct times)
+ *
+ * @pre Assumes temps[i] associates with times[i]
+ */
+std::vector<double> PolynomialLeastSquares::Calculate(std::span<const int> times, std::span<const double> temps) {
+	int numSamples = std::min(times.size(), temps.size());
+	int numCoefficients = degree + 1;
+	if (degree < 0 || numSamples < numCoefficients) {
+		return {};
+	}
+
+	//Map the times onto [-1, 1] so the powers stay well conditioned
+	auto [minTime, maxTime] = std::minmax_element(times.begin(), times.begin() + numSamples);
+	double center = (static_cast<double>(*minTime) + *maxTime) / 2.0;
+	double scale = (static_cast<double>(*maxTime) - *minTime) / 2.0;
+	if (scale <= 0.0) {
+		scale = 1.0;
+	}
+
+	DenseMatrix xTx(numCoefficients, numCoefficients);
+	std::vector<double> xTy(numCoefficients, 0.0);
+	DenseMatrix vandermonde(BLOCK_ROWS, numCoefficients);
+
+	for (int start = 0; start < numSamples; start += BLOCK_ROWS) {
+		int blockRows = std::min(BLOCK_ROWS, numSamples - start);
+		for (int r = 0; r < blockRows; r++) {
+			double s = (times[start + r] - center) / scale;
+			double* row = vandermonde.Row(r);
+			row[0] = 1.0;
+			for (int p = 1; p < numCoefficients; p++) {
+				row[p] = row[p - 1] * s;
+			}
+		}
+		xTx.AddGramUpper(vandermonde, blockRows);
+		DenseMatrix::AddTransposeProduct(vandermonde, blockRows, temps.subspan(start, blockRows), xTy);
+	}
+
+	xTx.MirrorUpper();
+	if (!xTx.CholeskyFactor()) {
+		return {};
+	}
+	xTx.CholeskySolve(xTy);
+	return Unscale(xTy, center, scale);
+}
+
+/**
+ * Appends the formatted line of the polynomial approximation for a core to a report.
+ * Line is formatted as such:
+ *
+ * minTime <= x < maxTime; y = c0 + c1x + c2x^2 ...; least-squares-degree-k
+ *
+ * @param report formatter to write the line into
+ * @param coefficients provides c0..ck of the approximation
+ * @param times provides the limits of the approximation
+ */
+void PolynomialLeastSquares::AppendTo(ReportFormatter& report, const std::vector<double>& coefficients, std::span<const int> times) {
+	if (coefficients.empty() || times.empty()) {
+		return;
+	}
+	report.AppendPolynomial(times[0], times[times.size() - 1], coefficients);
+}
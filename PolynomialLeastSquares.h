@@ -0,0 +1,74 @@
+/**
+ * The Polynomial Least Squares class will take a data set of one core
+ * and find a degree-k polynomial approximation of the whole data set
+ * (global) to calculate a y = c0 + c1x + c2x^2 + ... + ckx^k.
+ *
+ * The normal equations are built on a contiguous DenseMatrix one block of
+ * rows at a time and solved with a Cholesky factorization.
+ */
+#ifndef POLYNOMIAL_LEAST_SQUARES_H_INCLUDED
+#define POLYNOMIAL_LEAST_SQUARES_H_INCLUDED
+
+#include <span>
+#include <vector>
+
+#include "DenseMatrix.h"
+#include "ReportFormatter.h"
+
+class PolynomialLeastSquares
+{
+private:
+
+	static constexpr int BLOCK_ROWS = 256; //!< Rows of the Vandermonde matrix built at a time
+
+	int degree; //!< Highest power of x in the approximation
+
+	/**
+	 * Converts coefficients of a polynomial in s = (x - center) / scale into
+	 * coefficients of the same polynomial in x
+	 *
+	 * @param scaled coefficients in s, lowest power first
+	 * @param center shift that was applied to x
+	 * @param scale divisor that was applied to x
+	 *
+	 * @return coefficients in x, lowest power first
+	 */
+	std::vector<double> Unscale(const std::vector<double>& scaled, double center, double scale) const;
+
+public:
+
+	/**
+	 * Creates a calculator for polynomials of one degree
+	 *
+	 * @param degree highest power of x (1 is the linear least squares line)
+	 */
+	PolynomialLeastSquares(int degree) : degree(degree) {}
+
+	int GetDegree() const { return degree; }
+
+	/**
+	 * Calculates the coefficients c0..ck of the polynomial least squares approximation
+	 *
+	 * @param times provides list of the times
+	 * @param temps provides list of the temps of the target core
+	 *
+	 * @return the coefficients, lowest power first (empty if there are fewer
+	 *         than degree + 1 distinct times)
+	 *
+	 * @pre Assumes temps[i] associates with times[i]
+	 */
+	std::vector<double> Calculate(std::span<const int> times, std::span<const double> temps);
+
+	/**
+	 * Appends the formatted line of the polynomial approximation for a core to a report.
+	 * Line is formatted as such:
+	 *
+	 * minTime <= x < maxTime; y = c0 + c1x + c2x^2 ...; least-squares-degree-k
+	 *
+	 * @param report formatter to write the line into
+	 * @param coefficients provides c0..ck of the approximation
+	 * @param times provides the limits of the approximation
+	 */
+	void AppendTo(ReportFormatter& report, const std::vector<double>& coefficients, std::span<const int> times);
+};
+#endif
@@ -0,0 +1,261 @@
+#include "ReportFormatter.h"
+
+#include <charconv>
+#include <cstring>
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Makes sure one more line of any length fits in the buffer
+ *
+ * @return pointer to where the next line starts
+ */
+char* ReportFormatter::PrepareLine() {
+	if (used + MAX_LINE_LENGTH > buffer.size()) {
+		std::size_t grown = buffer.size() * 2;
+		buffer.resize(grown > used + MAX_LINE_LENGTH ? grown : used + MAX_LINE_LENGTH);
+	}
+	return buffer.data() + used;
+}
+
+/**
+ * Writes text without any padding
+ *
+ * @param pos where to write
+ * @param text characters to write
+ *
+ * @return pointer past the written characters
+ */
+char* ReportFormatter::WriteText(char* pos, std::string_view text) {
+	std::memcpy(pos, text.data(), text.size());
+	return pos + text.size();
+}
+
+/**
+ * Writes an integer padded with spaces to a minimum width
+ *
+ * @param pos where to write
+ * @param value number to write
+ * @param width minimum number of characters
+ * @param leftAlign pad on the right instead of the left
+ *
+ * @return pointer past the written characters
+ */
+char* ReportFormatter::WriteInt(char* pos, int value, int width, bool leftAlign) {
+	char* end = std::to_chars(pos, pos + MAX_LINE_LENGTH, value).ptr;
+	if (!leftAlign) {
+		return PadLeft(pos, end, width);
+	}
+	while (end - pos < width) {
+		*end++ = ' ';
+	}
+	return end;
+}
+
+/**
+ * Writes a double in fixed notation with 4 decimals, right aligned to a minimum width
+ *
+ * @param pos where to write
+ * @param value number to write
+ * @param width minimum number of characters
+ *
+ * @return pointer past the written characters
+ */
+char* ReportFormatter::WriteFixed(char* pos, double value, int width) {
+	char* end = std::to_chars(pos, pos + MAX_LINE_LENGTH, value, std::chars_format::fixed, PRECISION).ptr;
+	return PadLeft(pos, end, width);
+}
+
+/**
+ * Writes a double in scientific notation with 4 decimals, right aligned to a minimum width
+ *
+ * @param pos where to write
+ * @param value number to write
+ * @param width minimum number of characters
+ *
+ * @return pointer past the written characters
+ */
+char* ReportFormatter::WriteScientific(char* pos, double value, int width) {
+	char* end = std::to_chars(pos, pos + MAX_LINE_LENGTH, value, std::chars_format::scientific, PRECISION).ptr;
+	return PadLeft(pos, end, width);
+}
+
+/**
+ * Writes the start of a global approximation line, up to and including the " = "
+ *
+ * @param pos where to write
+ * @param minTime lower limit of the approximation
+ * @param maxTime upper limit of the approximation
+ *
+ * @return pointer past the written characters
+ */
+char* ReportFormatter::WriteGlobalPrefix(char* pos, int minTime, int maxTime) {
+	pos = WriteInt(pos, minTime, SPACING, false);
+	pos = WriteText(pos, " <= x <");
+	pos = WriteInt(pos, maxTime, SPACING, false);
+	//The label field is a blank padded out to SPACING
+	pos = WriteText(pos, "; y ");
+	pos = WriteText(pos, std::string_view("        ", SPACING));
+	return WriteText(pos, " = ");
+}
+
+/**
+ * Right aligns the last written characters within width
+ *
+ * @param start where the field starts
+ * @param end pointer past the written characters
+ * @param width minimum number of characters
+ *
+ * @return pointer past the padded field
+ */
+char* ReportFormatter::PadLeft(char* start, char* end, int width) {
+	int written = end - start;
+	if (written >= width) {
+		return end;
+	}
+	int padding = width - written;
+	std::memmove(start + padding, start, written);
+	std::memset(start, ' ', padding);
+	return start + width;
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Sets aside room for a number of lines so the buffer does not grow while writing
+ *
+ * @param numLines number of lines that will be appended
+ */
+void ReportFormatter::Reserve(std::size_t numLines) {
+	std::size_t needed = used + numLines * LINE_LENGTH + MAX_LINE_LENGTH;
+	if (needed > buffer.size()) {
+		buffer.resize(needed);
+	}
+}
+
+/**
+ * Appends one line of a piecewise linear interpolation
+ *
+ * @param time0 lower limit of the interpolation
+ * @param time1 upper limit of the interpolation
+ * @param index number of the interpolation (the # in y_#)
+ * @param intercept y-intercept (b)
+ * @param slope slope (m)
+ */
+void ReportFormatter::AppendInterpolation(int time0, int time1, int index, double intercept, double slope) {
+	char* start = PrepareLine();
+	char* pos = WriteInt(start, time0, SPACING, false);
+	pos = WriteText(pos, " <= x <");
+	pos = WriteInt(pos, time1, SPACING, false);
+	pos = WriteText(pos, "; y_");
+	pos = WriteInt(pos, index, SPACING, true);
+	pos = WriteText(pos, " = ");
+	pos = WriteFixed(pos, intercept, COEFFICIENT_WIDTH);
+	pos = WriteText(pos, " + ");
+	pos = WriteFixed(pos, slope, COEFFICIENT_WIDTH);
+	pos = WriteText(pos, "x; interpolation\n");
+	used += pos - start;
+}
+
+/**
+ * Appends the line of a global least squares approximation
+ *
+ * @param minTime lower limit of the approximation
+ * @param maxTime upper limit of the approximation
+ * @param intercept intercept (c0)
+ * @param slope slope (c1)
+ */
+void ReportFormatter::AppendLeastSquares(int minTime, int maxTime, double intercept, double slope) {
+	char* start = PrepareLine();
+	char* pos = WriteGlobalPrefix(start, minTime, maxTime);
+	pos = WriteFixed(pos, intercept, COEFFICIENT_WIDTH);
+	pos = WriteText(pos, " + ");
+	pos = WriteFixed(pos, slope, COEFFICIENT_WIDTH);
+	pos = WriteText(pos, "x; least-squares\n");
+	used += pos - start;
+}
+
+/**
+ * Appends the line of a least squares approximation of one window of a
+ * rolling trend, laid out like the global least squares line
+ *
+ * @param minTime time of the first reading in the window
+ * @param maxTime time of the last reading in the window
+ * @param intercept intercept (c0)
+ * @param slope slope (c1)
+ */
+void ReportFormatter::AppendRollingLeastSquares(int minTime, int maxTime, double intercept, double slope) {
+	char* start = PrepareLine();
+	char* pos = WriteGlobalPrefix(start, minTime, maxTime);
+	pos = WriteFixed(pos, intercept, COEFFICIENT_WIDTH);
+	pos = WriteText(pos, " + ");
+	pos = WriteFixed(pos, slope, COEFFICIENT_WIDTH);
+	pos = WriteText(pos, "x; rolling-least-squares\n");
+	used += pos - start;
+}
+
+/**
+ * Appends the line of a global polynomial least squares approximation.
+ * c0 is written like the least squares line; c1 and the higher powers are
+ * written in scientific notation, since over a long log they are small
+ * enough to round to 0.0000 while still moving the line by degrees.
+ *
+ * @param minTime lower limit of the approximation
+ * @param maxTime upper limit of the approximation
+ * @param coefficients c0..ck, lowest power first
+ *
+ * @pre coefficients.size() >= 2 && coefficients.size() <= 16
+ */
+void ReportFormatter::AppendPolynomial(int minTime, int maxTime, std::span<const double> coefficients) {
+	char* start = PrepareLine();
+	char* pos = WriteGlobalPrefix(start, minTime, maxTime);
+	pos = WriteFixed(pos, coefficients[0], COEFFICIENT_WIDTH);
+	pos = WriteText(pos, " + ");
+	pos = WriteScientific(pos, coefficients[1], COEFFICIENT_WIDTH);
+	pos = WriteText(pos, "x");
+	for (int power = 2; power < coefficients.size(); power++) {
+		pos = WriteText(pos, " + ");
+		pos = WriteScientific(pos, coefficients[power], COEFFICIENT_WIDTH);
+		pos = WriteText(pos, "x^");
+		pos = WriteInt(pos, power, 0, true);
+	}
+	pos = WriteText(pos, "; least-squares-degree-");
+	pos = WriteInt(pos, coefficients.size() - 1, 0, true);
+	pos = WriteText(pos, "\n");
+	used += pos - start;
+}
+
+/**
+ * Appends the line of one pair of cores of a core-to-core correlation.
+ * A variance is the pair of a core with itself.
+ *
+ * @param core0 number of the first core
+ * @param core1 number of the second core
+ * @param covariance sample covariance of the two cores
+ * @param correlation Pearson correlation of the two cores (nan if either core never changes)
+ */
+void ReportFormatter::AppendCorrelation(int core0, int core1, double covariance, double correlation) {
+	char* start = PrepareLine();
+	char* pos = WriteInt(start, core0, SPACING, false);
+	pos = WriteText(pos, " ~ ");
+	pos = WriteInt(pos, core1, SPACING, true);
+	pos = WriteText(pos, "; cov = ");
+	pos = WriteFixed(pos, covariance, COEFFICIENT_WIDTH);
+	pos = WriteText(pos, "; r = ");
+	pos = WriteFixed(pos, correlation, COEFFICIENT_WIDTH);
+	pos = WriteText(pos, "; correlation\n");
+	used += pos - start;
+}
+
+/**
+ * Hands over the formatted text and leaves the formatter empty
+ *
+ * @return string to be used in output
+ */
+std::string ReportFormatter::Take() {
+	buffer.resize(used);
+	used = 0;
+	std::string retVal = std::move(buffer);
+	buffer.clear();
+	return retVal;
+}
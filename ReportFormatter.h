@@ -0,0 +1,203 @@
+/**
+ * The Report Formatter class writes the fixed width report lines straight
+ * into one preallocated buffer with std::to_chars. It produces the same
+ * bytes as streaming the fields through setw, setfill and setprecision(4).
+ *
+ * Each line follows a format akin to:
+ *
+ * time1 <= x < time2; y_# = b + mx; interpolation
+ * minTime <= x < maxTime; y = c0 + c1x; least-squares
+ * minTime <= x < maxTime; y = c0 + c1x + c2x^2 ...; least-squares-degree-k
+ * core0 ~ core1; cov = c; r = r; correlation
+ */
+#ifndef REPORT_FORMATTER_H_INCLUDED
+#define REPORT_FORMATTER_H_INCLUDED
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+class ReportFormatter
+{
+private:
+
+	static constexpr int SPACING = 8; //!< Width of the time and index fields
+	static constexpr int COEFFICIENT_WIDTH = SPACING + (SPACING / 2); //!< Width of the slope and intercept fields
+	static constexpr int PRECISION = 4; //!< Digits after the decimal point of slope and intercept
+
+	/**
+	 * Length of a line when every field fits its width. Both kinds of line
+	 * have the same length.
+	 */
+	static constexpr std::size_t LINE_LENGTH = SPACING + 7 + SPACING + 4 + SPACING + 3
+		+ COEFFICIENT_WIDTH + 3 + COEFFICIENT_WIDTH + 16 + 1;
+
+	/**
+	 * Room needed for any single line, including fields that overflow their
+	 * widths (i.e. a huge double printed in fixed notation)
+	 */
+	static constexpr std::size_t MAX_LINE_LENGTH = 1024;
+
+	std::string buffer = ""; //!< Output storage, sized ahead of the bytes actually written
+	std::size_t used = 0; //!< Number of bytes of buffer that hold output
+
+	/**
+	 * Makes sure one more line of any length fits in the buffer
+	 *
+	 * @return pointer to where the next line starts
+	 */
+	char* PrepareLine();
+
+	/**
+	 * Writes text without any padding
+	 *
+	 * @param pos where to write
+	 * @param text characters to write
+	 *
+	 * @return pointer past the written characters
+	 */
+	static char* WriteText(char* pos, std::string_view text);
+
+	/**
+	 * Writes an integer padded with spaces to a minimum width
+	 *
+	 * @param pos where to write
+	 * @param value number to write
+	 * @param width minimum number of characters
+	 * @param leftAlign pad on the right instead of the left
+	 *
+	 * @return pointer past the written characters
+	 */
+	static char* WriteInt(char* pos, int value, int width, bool leftAlign);
+
+	/**
+	 * Writes a double in fixed notation with 4 decimals, right aligned to a minimum width
+	 *
+	 * @param pos where to write
+	 * @param value number to write
+	 * @param width minimum number of characters
+	 *
+	 * @return pointer past the written characters
+	 */
+	static char* WriteFixed(char* pos, double value, int width);
+
+	/**
+	 * Writes a double in scientific notation with 4 decimals, right aligned to a minimum width
+	 *
+	 * @param pos where to write
+	 * @param value number to write
+	 * @param width minimum number of characters
+	 *
+	 * @return pointer past the written characters
+	 */
+	static char* WriteScientific(char* pos, double value, int width);
+
+	/**
+	 * Writes the start of a global approximation line, up to and including the " = "
+	 *
+	 * @param pos where to write
+	 * @param minTime lower limit of the approximation
+	 * @param maxTime upper limit of the approximation
+	 *
+	 * @return pointer past the written characters
+	 */
+	static char* WriteGlobalPrefix(char* pos, int minTime, int maxTime);
+
+	/**
+	 * Right aligns the last written characters within width
+	 *
+	 * @param start where the field starts
+	 * @param end pointer past the written characters
+	 * @param width minimum number of characters
+	 *
+	 * @return pointer past the padded field
+	 */
+	static char* PadLeft(char* start, char* end, int width);
+
+public:
+
+	/**
+	 * Sets aside room for a number of lines so the buffer does not grow while writing
+	 *
+	 * @param numLines number of lines that will be appended
+	 */
+	void Reserve(std::size_t numLines);
+
+	/**
+	 * Appends one line of a piecewise linear interpolation
+	 *
+	 * @param time0 lower limit of the interpolation
+	 * @param time1 upper limit of the interpolation
+	 * @param index number of the interpolation (the # in y_#)
+	 * @param intercept y-intercept (b)
+	 * @param slope slope (m)
+	 */
+	void AppendInterpolation(int time0, int time1, int index, double intercept, double slope);
+
+	/**
+	 * Appends the line of a global least squares approximation
+	 *
+	 * @param minTime lower limit of the approximation
+	 * @param maxTime upper limit of the approximation
+	 * @param intercept intercept (c0)
+	 * @param slope slope (c1)
+	 */
+	void AppendLeastSquares(int minTime, int maxTime, double intercept, double slope);
+
+	/**
+	 * Appends the line of a least squares approximation of one window of a
+	 * rolling trend, laid out like the global least squares line
+	 *
+	 * @param minTime time of the first reading in the window
+	 * @param maxTime time of the last reading in the window
+	 * @param intercept intercept (c0)
+	 * @param slope slope (c1)
+	 */
+	void AppendRollingLeastSquares(int minTime, int maxTime, double intercept, double slope);
+
+	/**
+	 * Appends the line of a global polynomial least squares approximation.
+	 * c0 is written like the least squares line; c1 and the higher powers are
+	 * written in scientific notation, since over a long log they are small
+	 * enough to round to 0.0000 while still moving the line by degrees.
+	 *
+	 * @param minTime lower limit of the approximation
+	 * @param maxTime upper limit of the approximation
+	 * @param coefficients c0..ck, lowest power first
+	 *
+	 * @pre coefficients.size() >= 2 && coefficients.size() <= 16
+	 */
+	void AppendPolynomial(int minTime, int maxTime, std::span<const double> coefficients);
+
+	/**
+	 * Appends the line of one pair of cores of a core-to-core correlation.
+	 * A variance is the pair of a core with itself.
+	 *
+	 * @param core0 number of the first core
+	 * @param core1 number of the second core
+	 * @param covariance sample covariance of the two cores
+	 * @param correlation Pearson correlation of the two cores (nan if either core never changes)
+	 */
+	void AppendCorrelation(int core0, int core1, double covariance, double correlation);
+
+	/**
+	 * Provides the text written so far
+	 *
+	 * @return a view of the formatted lines
+	 */
+	std::string_view View() const { return std::string_view(buffer.data(), used); }
+
+	/**
+	 * Empties the formatter but keeps its buffer for the next lines
+	 */
+	void Clear() { used = 0; }
+
+	/**
+	 * Hands over the formatted text and leaves the formatter empty
+	 *
+	 * @return string to be used in output
+	 */
+	std::string Take();
+};
+#endif
@@ -0,0 +1,102 @@
+#include "ReportWriter.h"
+
+#include <fstream>
+#include <string_view>
+
+static constexpr const char* MODEL_SUFFIX = "-model.bin"; //!< Ending of every model file name
+
+/**
+ * Works out the base name shared by all reports of an input file (the
+ * input file name without its extension)
+ *
+ * @param inputFileName name of the input log
+ *
+ * @return the base name
+ */
+std::string outputBaseName(const std::string& inputFileName) {
+	std::string fn = inputFileName;
+	//Get only the filename of the base file (no extensions)
+	size_t extensionSpot = fn.find_last_of('.');
+	if (extensionSpot != std::string::npos) {
+		if (extensionSpot > 1) {
+			fn = fn.substr(0, extensionSpot - 1);
+		}
+	}
+	return fn;
+}
+
+/**
+ * Names the report of one core
+ *
+ * @param inputFileName name of the input log
+ * @param core number of the core
+ *
+ * @return file name of the form <base>-core-N.txt
+ */
+std::string coreReportName(const std::string& inputFileName, int core) {
+	return outputBaseName(inputFileName) + "-core-" + std::to_string(core) + ".txt";
+}
+
+/**
+ * Names the binary model file of an input file
+ *
+ * @param inputFileName name of the input log
+ *
+ * @return file name of the form <base>-model.bin
+ */
+std::string modelFileName(const std::string& inputFileName) {
+	return outputBaseName(inputFileName) + MODEL_SUFFIX;
+}
+
+/**
+ * Names the core-to-core covariance and correlation report of an input file
+ *
+ * @param inputFileName name of the input log
+ *
+ * @return file name of the form <base>-correlation.txt
+ */
+std::string correlationReportName(const std::string& inputFileName) {
+	return outputBaseName(inputFileName) + "-correlation.txt";
+}
+
+/**
+ * Works out the report base name from a model file name, the inverse of
+ * modelFileName
+ *
+ * @param modelName name of the model file
+ *
+ * @return the base name the model was written under
+ */
+std::string modelBaseName(const std::string& modelName) {
+	std::string_view suffix = MODEL_SUFFIX;
+	if (modelName.size() > suffix.size() && modelName.ends_with(suffix)) {
+		return modelName.substr(0, modelName.size() - suffix.size());
+	}
+	//Not named by modelFileName, so drop the extension
+	size_t extensionSpot = modelName.find_last_of('.');
+	return extensionSpot == std::string::npos ? modelName : modelName.substr(0, extensionSpot);
+}
+
+/**
+ * Writes each core's report to <baseName>-core-N.txt
+ *
+ * @param coreOutputs formatted report of every core, in core order
+ * @param baseName base name shared by the reports
+ */
+void writeCoreReports(const std::vector<std::string>& coreOutputs, const std::string& baseName) {
+	for (int core = 0; core < coreOutputs.size(); core++) {
+		std::ofstream coreOut(baseName + "-core-" + std::to_string(core) + ".txt");
+		coreOut << coreOutputs[core];
+		coreOut.close();
+	}
+}
+
+/**
+ * Writes each core's report to its own file
+ *
+ * @param coreOutputs formatted report of every core, in core order
+ * @param inputFileName name of the input log the reports came from
+ */
+void outputOrganizer(const std::vector<std::string>& coreOutputs, const std::string& inputFileName) {
+	writeCoreReports(coreOutputs, outputBaseName(inputFileName));
+}
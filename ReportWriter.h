@@ -0,0 +1,74 @@
+/**
+ * Functions that decide where the per-core reports of an input file go
+ * and write them there.
+ */
+#ifndef REPORT_WRITER_H_INCLUDED
+#define REPORT_WRITER_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+/**
+ * Works out the base name shared by all reports of an input file (the
+ * input file name without its extension)
+ *
+ * @param inputFileName name of the input log
+ *
+ * @return the base name
+ */
+std::string outputBaseName(const std::string& inputFileName);
+
+/**
+ * Names the report of one core
+ *
+ * @param inputFileName name of the input log
+ * @param core number of the core
+ *
+ * @return file name of the form <base>-core-N.txt
+ */
+std::string coreReportName(const std::string& inputFileName, int core);
+
+/**
+ * Names the binary model file of an input file
+ *
+ * @param inputFileName name of the input log
+ *
+ * @return file name of the form <base>-model.bin
+ */
+std::string modelFileName(const std::string& inputFileName);
+
+/**
+ * Names the core-to-core covariance and correlation report of an input file
+ *
+ * @param inputFileName name of the input log
+ *
+ * @return file name of the form <base>-correlation.txt
+ */
+std::string correlationReportName(const std::string& inputFileName);
+
+/**
+ * Works out the report base name from a model file name, the inverse of
+ * modelFileName
+ *
+ * @param modelName name of the model file
+ *
+ * @return the base name the model was written under
+ */
+std::string modelBaseName(const std::string& modelName);
+
+/**
+ * Writes each core's report to <baseName>-core-N.txt
+ *
+ * @param coreOutputs formatted report of every core, in core order
+ * @param baseName base name shared by the reports
+ */
+void writeCoreReports(const std::vector<std::string>& coreOutputs, const std::string& baseName);
+
+/**
+ * Writes each core's report to its own file
+ *
+ * @param coreOutputs formatted report of every core, in core order
+ * @param inputFileName name of the input log the reports came from
+ */
+void outputOrganizer(const std::vector<std::string>& coreOutputs, const std::string& inputFileName);
+#endif
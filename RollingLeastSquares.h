@@ -0,0 +1,93 @@
+/**
+ * The Rolling Least Squares class keeps the linear least squares fit of a
+ * sliding window of samples. Samples are added as they enter the window and
+ * removed as they leave it, each in O(1).
+ *
+ * Instead of raw sums of time and time * time (which grow with the time
+ * stamps and cancel badly when samples are removed), the class keeps the
+ * means and the sums of deviations from the means, updated with Welford's
+ * method and its inverse.
+ */
+#ifndef ROLLING_LEAST_SQUARES_H_INCLUDED
+#define ROLLING_LEAST_SQUARES_H_INCLUDED
+
+class RollingLeastSquares
+{
+private:
+
+	long long count = 0; //!< Number of samples in the window
+	double meanTime = 0.0; //!< Mean of the times in the window
+	double meanTemp = 0.0; //!< Mean of the temps in the window
+	double sumSquares = 0.0; //!< Sum of (time - meanTime)^2
+	double sumProducts = 0.0; //!< Sum of (time - meanTime) * (temp - meanTemp)
+
+public:
+
+	/**
+	 * Adds a sample entering the window
+	 *
+	 * @param time time of the reading
+	 * @param temp temp associated with the time reading
+	 */
+	void Add(double time, double temp) {
+		count++;
+		double timeOffset = time - meanTime;
+		meanTime += timeOffset / count;
+		meanTemp += (temp - meanTemp) / count;
+		sumSquares += timeOffset * (time - meanTime);
+		sumProducts += timeOffset * (temp - meanTemp);
+	}
+
+	/**
+	 * Removes a sample leaving the window (the inverse of Add)
+	 *
+	 * @param time time of the reading
+	 * @param temp temp associated with the time reading
+	 *
+	 * @pre the sample was added and not removed yet
+	 */
+	void Remove(double time, double temp) {
+		if (count <= 1) {
+			Reset();
+			return;
+		}
+		double oldMeanTime = meanTime;
+		double oldMeanTemp = meanTemp;
+		count--;
+		meanTime -= (time - meanTime) / count;
+		meanTemp -= (temp - meanTemp) / count;
+
+		//Add's update run backwards: the offset from the new mean times the offset from the old one
+		double timeOffset = time - meanTime;
+		sumSquares -= timeOffset * (time - oldMeanTime);
+		sumProducts -= timeOffset * (temp - oldMeanTemp);
+	}
+
+	/**
+	 * Empties the window
+	 */
+	void Reset() {
+		count = 0;
+		meanTime = 0.0;
+		meanTemp = 0.0;
+		sumSquares = 0.0;
+		sumProducts = 0.0;
+	}
+
+	long long GetCount() const { return count; }
+
+	/**
+	 * Fetches the slope (c1) of the fit
+	 *
+	 * @return the slope, 0 if the window has fewer than two distinct times
+	 */
+	double GetSlope() const { return sumSquares > 0.0 ? sumProducts / sumSquares : 0.0; }
+
+	/**
+	 * Fetches the intercept (c0) of the fit
+	 *
+	 * @return the intercept
+	 */
+	double GetIntercept() const { return meanTemp - GetSlope() * meanTime; }
+};
+#endif
@@ -0,0 +1,142 @@
+#include "RollingTrend.h"
+
+#include "RollingLeastSquares.h"
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Moves the start of the window forward until the window ending at end fits
+ *
+ * @param times provides the times of the readings
+ * @param start index of the first reading in the window
+ * @param end index of the last reading in the window
+ *
+ * @return index of the first reading of the window ending at end
+ */
+std::size_t RollingTrend::AdvanceStart(std::span<const int> times, std::size_t start, std::size_t end) const {
+	if (inSeconds) {
+		//The window covers (times[end] - windowSize, times[end]]
+		while (start < end && times[end] - times[start] >= windowSize) {
+			start++;
+		}
+	}
+	else {
+		while (end - start + 1 > windowSize) {
+			start++;
+		}
+	}
+	return start;
+}
+
+/**
+ * Checks if the window ending at end covers its whole width
+ *
+ * @param times provides the times of the readings
+ * @param start index of the first reading in the window
+ * @param end index of the last reading in the window
+ *
+ * @return true if a fit should be produced for this window
+ */
+bool RollingTrend::IsFull(std::span<const int> times, std::size_t start, std::size_t end) const {
+	if (end - start + 1 < 2) {
+		return false;
+	}
+	if (inSeconds) {
+		return times[end] - times[0] >= windowSize;
+	}
+	return end - start + 1 == windowSize;
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Sets up a trend calculation
+ *
+ * @param windowSize width of the window
+ * @param inSeconds true if windowSize is in seconds, false if it is in samples
+ *
+ * @pre windowSize >= 2 when in samples
+ */
+RollingTrend::RollingTrend(int windowSize, bool inSeconds) : windowSize(windowSize), inSeconds(inSeconds) {
+}
+
+/**
+ * Fits every window position of every core in one pass over the readings
+ *
+ * @param data provides the times and the temps of every core
+ */
+void RollingTrend::Calculate(const DataPreProcessor& data) {
+	std::span<const int> times = data.GetTimes();
+	int numCores = data.GetNumCores();
+
+	//The windows only depend on the times, so find them first to size the table
+	windowStarts.clear();
+	windowEnds.clear();
+	for (std::size_t end = 0, start = 0; end < times.size(); end++) {
+		start = AdvanceStart(times, start, end);
+		if (IsFull(times, start, end)) {
+			windowStarts.push_back(times[start]);
+			windowEnds.push_back(times[end]);
+		}
+	}
+	fits.Resize(numCores, windowStarts.size());
+
+	std::vector<RollingLeastSquares> windows(numCores);
+	std::vector<std::span<const double>> temps(numCores);
+	for (int core = 0; core < numCores; core++) {
+		temps[core] = data.GetCoreReadings(core);
+	}
+
+	std::size_t start = 0;
+	std::size_t removedSinceRebuild = 0;
+	std::size_t fit = 0;
+	for (std::size_t end = 0; end < times.size(); end++) {
+		for (int core = 0; core < numCores; core++) {
+			windows[core].Add(times[end], temps[core][end]);
+		}
+
+		std::size_t newStart = AdvanceStart(times, start, end);
+		for (; start < newStart; start++, removedSinceRebuild++) {
+			for (int core = 0; core < numCores; core++) {
+				windows[core].Remove(times[start], temps[core][start]);
+			}
+		}
+
+		//Rounding creeps in with every removal, so once a window's worth has
+		//gone the sums are rebuilt from the window (O(1) per sample on average)
+		if (removedSinceRebuild >= end - start + 1) {
+			for (int core = 0; core < numCores; core++) {
+				windows[core].Reset();
+				for (std::size_t i = start; i <= end; i++) {
+					windows[core].Add(times[i], temps[core][i]);
+				}
+			}
+			removedSinceRebuild = 0;
+		}
+
+		if (IsFull(times, start, end)) {
+			for (int core = 0; core < numCores; core++) {
+				fits.GetSlopes(core)[fit] = windows[core].GetSlope();
+				fits.GetIntercepts(core)[fit] = windows[core].GetIntercept();
+			}
+			fit++;
+		}
+	}
+}
+
+/**
+ * Appends one line per window of a core to a report
+ *
+ * @param report formatter to write the lines into
+ * @param coreNum specifies which core
+ *
+ * @pre Calculate was run and coreNum is one of its cores
+ */
+void RollingTrend::AppendTo(ReportFormatter& report, int coreNum) const {
+	std::span<const double> slopes = fits.GetSlopes(coreNum);
+	std::span<const double> intercepts = fits.GetIntercepts(coreNum);
+	report.Reserve(windowStarts.size());
+	for (std::size_t i = 0; i < windowStarts.size(); i++) {
+		report.AppendRollingLeastSquares(windowStarts[i], windowEnds[i], intercepts[i], slopes[i]);
+	}
+}
@@ -0,0 +1,94 @@
+/**
+ * The Rolling Trend class fits a line to a sliding window of readings of
+ * every core, giving one slope and intercept per window position. It walks
+ * the readings once: each step adds the newest sample of every core and
+ * removes the ones that left the window, so a fit costs O(1) no matter how
+ * wide the window is.
+ *
+ * The window is either a number of samples or a number of seconds. A fit is
+ * produced for every reading once the first window is full.
+ */
+#ifndef ROLLING_TREND_H_INCLUDED
+#define ROLLING_TREND_H_INCLUDED
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "DataPreProcessor.h"
+#include "InterpolationTable.h"
+#include "ReportFormatter.h"
+
+class RollingTrend
+{
+private:
+
+	int windowSize; //!< Width of the window in samples or seconds
+	bool inSeconds; //!< Whether windowSize is in seconds
+
+	std::vector<int> windowStarts = {}; //!< Time of the first reading of every window
+	std::vector<int> windowEnds = {}; //!< Time of the last reading of every window
+	InterpolationTable fits; //!< Slope and intercept of every window, one column per core
+
+	/**
+	 * Moves the start of the window forward until the window ending at end fits
+	 *
+	 * @param times provides the times of the readings
+	 * @param start index of the first reading in the window
+	 * @param end index of the last reading in the window
+	 *
+	 * @return index of the first reading of the window ending at end
+	 */
+	std::size_t AdvanceStart(std::span<const int> times, std::size_t start, std::size_t end) const;
+
+	/**
+	 * Checks if the window ending at end covers its whole width
+	 *
+	 * @param times provides the times of the readings
+	 * @param start index of the first reading in the window
+	 * @param end index of the last reading in the window
+	 *
+	 * @return true if a fit should be produced for this window
+	 */
+	bool IsFull(std::span<const int> times, std::size_t start, std::size_t end) const;
+
+public:
+
+	/**
+	 * Sets up a trend calculation
+	 *
+	 * @param windowSize width of the window
+	 * @param inSeconds true if windowSize is in seconds, false if it is in samples
+	 *
+	 * @pre windowSize >= 2 when in samples
+	 */
+	RollingTrend(int windowSize, bool inSeconds = false);
+
+	/**
+	 * Fits every window position of every core in one pass over the readings
+	 *
+	 * @param data provides the times and the temps of every core
+	 */
+	void Calculate(const DataPreProcessor& data);
+
+	/**
+	 * Fetches how many windows were fitted
+	 *
+	 * @return the number of fits per core
+	 */
+	std::size_t GetNumWindows() const { return windowStarts.size(); }
+
+	std::span<const double> GetSlopes(int coreNum) const { return fits.GetSlopes(coreNum); }
+	std::span<const double> GetIntercepts(int coreNum) const { return fits.GetIntercepts(coreNum); }
+
+	/**
+	 * Appends one line per window of a core to a report
+	 *
+	 * @param report formatter to write the lines into
+	 * @param coreNum specifies which core
+	 *
+	 * @pre Calculate was run and coreNum is one of its cores
+	 */
+	void AppendTo(ReportFormatter& report, int coreNum) const;
+};
+#endif
@@ -0,0 +1,174 @@
+#include "SensorSampler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+	/**
+	 * Reads the number after a prefix in a name (i.e. 12 in "hwmon12")
+	 *
+	 * @param name the name
+	 * @param prefix text before the number
+	 * @param number updated with the number
+	 *
+	 * @return false if name does not start with prefix followed by a number
+	 */
+	bool numberAfter(const std::string& name, const std::string& prefix, int& number) {
+		if (!name.starts_with(prefix)) {
+			return false;
+		}
+		const char* end = name.data() + name.size();
+		std::from_chars_result result = std::from_chars(name.data() + prefix.size(), end, number);
+		return result.ec == std::errc() && result.ptr != name.data() + prefix.size();
+	}
+
+	/**
+	 * Reads the first line of a small sysfs file (i.e. a label)
+	 *
+	 * @param fileName path of the file
+	 *
+	 * @return the line, empty if the file cannot be read
+	 */
+	std::string readLine(const std::filesystem::path& fileName) {
+		std::ifstream input(fileName);
+		std::string line;
+		std::getline(input, line);
+		return line;
+	}
+
+	/**
+	 * Lists the entries of a directory named prefix followed by a number,
+	 * in numeric order (so hwmon10 comes after hwmon9)
+	 *
+	 * @param directory the directory
+	 * @param prefix text before the number
+	 *
+	 * @return the number and path of every matching entry
+	 */
+	std::vector<std::pair<int, std::filesystem::path>> numberedEntries(const std::filesystem::path& directory, const std::string& prefix) {
+		std::vector<std::pair<int, std::filesystem::path>> entries;
+		std::error_code error;
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory, error)) {
+			int number;
+			if (numberAfter(entry.path().filename().string(), prefix, number)) {
+				entries.emplace_back(number, entry.path());
+			}
+		}
+		std::sort(entries.begin(), entries.end());
+		return entries;
+	}
+}
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Opens the temperature files in one sysfs class, in numeric order of
+ * their devices
+ *
+ * @param className "hwmon" or "thermal"
+ */
+void SensorSampler::OpenClass(const std::string& className) {
+	std::filesystem::path classDir = std::filesystem::path(sysfsRoot) / "class" / className;
+	if (className == "thermal") {
+		for (const auto& [zone, zoneDir] : numberedEntries(classDir, "thermal_zone")) {
+			std::string label = readLine(zoneDir / "type");
+			OpenSensor((zoneDir / "temp").string(), zoneDir.filename().string() + (label.empty() ? "" : " (" + label + ")"));
+		}
+		return;
+	}
+
+	for (const auto& [device, deviceDir] : numberedEntries(classDir, "hwmon")) {
+		std::string deviceName = readLine(deviceDir / "name");
+		std::vector<std::pair<int, std::filesystem::path>> inputs;
+		for (const auto& [sensor, sensorFile] : numberedEntries(deviceDir, "temp")) {
+			if (sensorFile.filename().string().ends_with("_input")) {
+				inputs.emplace_back(sensor, sensorFile);
+			}
+		}
+		for (const auto& [sensor, sensorFile] : inputs) {
+			std::string label = readLine(deviceDir / ("temp" + std::to_string(sensor) + "_label"));
+			if (!deviceName.empty() && !label.empty()) {
+				label = deviceName + " " + label;
+			}
+			else if (label.empty()) {
+				label = deviceName;
+			}
+			std::string name = deviceDir.filename().string() + "/" + sensorFile.filename().string();
+			OpenSensor(sensorFile.string(), name + (label.empty() ? "" : " (" + label + ")"));
+		}
+	}
+}
+
+/**
+ * Opens one temperature file and names it
+ *
+ * @param fileName path of the temperature file
+ * @param name where it was found, and its label
+ */
+void SensorSampler::OpenSensor(const std::string& fileName, const std::string& name) {
+	int fd = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	sensorFds.push_back(fd);
+	sensorNames.push_back(name);
+	lastTemps.push_back(0.0);
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Finds and opens every temperature file
+ *
+ * @param sysfsRoot directory holding class/hwmon and class/thermal
+ */
+SensorSampler::SensorSampler(const std::string& sysfsRoot) : sysfsRoot(sysfsRoot) {
+	OpenClass("hwmon");
+	OpenClass("thermal");
+}
+
+/**
+ * Closes every temperature file
+ */
+SensorSampler::~SensorSampler() {
+	for (int fd : sensorFds) {
+		close(fd);
+	}
+}
+
+/**
+ * Reads every sensor once. A sensor that cannot be read keeps its last
+ * temperature (0 before its first good read).
+ *
+ * @param temps updated with one temperature per sensor, in degrees
+ *
+ * @return the number of sensors read successfully
+ *
+ * @pre temps.size() >= GetNumSensors()
+ */
+int SensorSampler::Sample(std::span<double> temps) {
+	int numRead = 0;
+	char text[32];
+	for (std::size_t sensor = 0; sensor < sensorFds.size(); sensor++) {
+		ssize_t length;
+		do {
+			length = pread(sensorFds[sensor], text, sizeof(text), 0);
+		} while (length < 0 && errno == EINTR);
+
+		//Millidegrees as a decimal integer, usually followed by '\n'
+		long millidegrees;
+		if (length > 0 && std::from_chars(text, text + length, millidegrees).ec == std::errc()) {
+			lastTemps[sensor] = millidegrees / 1000.0;
+			numRead++;
+		}
+		temps[sensor] = lastTemps[sensor];
+	}
+	return numRead;
+}
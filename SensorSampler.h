@@ -0,0 +1,77 @@
+/**
+ * The Sensor Sampler reads the temperature of every sensor the kernel
+ * exposes in sysfs:
+ *
+ *   <root>/class/hwmon/hwmonN/tempM_input     (i.e. coretemp, k10temp, nvme)
+ *   <root>/class/thermal/thermal_zoneN/temp   (i.e. x86_pkg_temp, acpitz)
+ *
+ * Both hold the temperature in millidegrees Celsius. Every file is opened
+ * once and read again with pread at offset 0, which sysfs answers with a
+ * fresh value, so a sample costs one system call per sensor. The root is
+ * normally /sys, and can point at a copy of the tree for testing.
+ */
+#ifndef SENSOR_SAMPLER_H_INCLUDED
+#define SENSOR_SAMPLER_H_INCLUDED
+
+#include <span>
+#include <string>
+#include <vector>
+
+class SensorSampler
+{
+private:
+
+	std::string sysfsRoot; //!< Directory holding class/hwmon and class/thermal
+	std::vector<int> sensorFds = {}; //!< Open temperature file of every sensor
+	std::vector<std::string> sensorNames = {}; //!< Where every sensor was found, and its label
+	std::vector<double> lastTemps = {}; //!< Last temperature read from every sensor
+
+	/**
+	 * Opens the temperature files in one sysfs class, in numeric order of
+	 * their devices
+	 *
+	 * @param className "hwmon" or "thermal"
+	 */
+	void OpenClass(const std::string& className);
+
+	/**
+	 * Opens one temperature file and names it
+	 *
+	 * @param fileName path of the temperature file
+	 * @param name where it was found, and its label
+	 */
+	void OpenSensor(const std::string& fileName, const std::string& name);
+
+public:
+
+	/**
+	 * Finds and opens every temperature file
+	 *
+	 * @param sysfsRoot directory holding class/hwmon and class/thermal
+	 */
+	SensorSampler(const std::string& sysfsRoot = "/sys");
+
+	/**
+	 * Closes every temperature file
+	 */
+	~SensorSampler();
+
+	SensorSampler(const SensorSampler&) = delete;
+	SensorSampler& operator=(const SensorSampler&) = delete;
+
+	/**
+	 * Reads every sensor once. A sensor that cannot be read keeps its last
+	 * temperature (0 before its first good read).
+	 *
+	 * @param temps updated with one temperature per sensor, in degrees
+	 *
+	 * @return the number of sensors read successfully
+	 *
+	 * @pre temps.size() >= GetNumSensors()
+	 */
+	int Sample(std::span<double> temps);
+
+	int GetNumSensors() const { return sensorFds.size(); }
+	const std::vector<std::string>& GetSensorNames() const { return sensorNames; }
+};
+#endif
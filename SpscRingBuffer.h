@@ -0,0 +1,101 @@
+/**
+ * The SPSC Ring Buffer passes fixed-size rows of values from one producer
+ * thread to one consumer thread without locks. Each side only writes its
+ * own index (the producer the tail, the consumer the head) and reads the
+ * other's with acquire ordering, so a row is fully written before the
+ * consumer can see it and fully read before the producer can reuse it.
+ *
+ * Rows are pushed and popped whole. The capacity is rounded up to a power
+ * of two so positions wrap with a mask, and the indices only ever grow.
+ */
+#ifndef SPSC_RING_BUFFER_H_INCLUDED
+#define SPSC_RING_BUFFER_H_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+template<typename T>
+class SpscRingBuffer
+{
+private:
+
+	static constexpr std::size_t CACHE_LINE = 64; //!< Keeps the two indices from sharing a cache line
+
+	std::size_t rowSize; //!< Values in every row
+	std::size_t mask; //!< Number of row slots minus 1
+	std::vector<T> slots; //!< Storage for every row slot
+
+	alignas(CACHE_LINE) std::atomic<std::size_t> head = 0; //!< Rows popped so far (written by the consumer only)
+	alignas(CACHE_LINE) std::atomic<std::size_t> tail = 0; //!< Rows pushed so far (written by the producer only)
+
+public:
+
+	/**
+	 * Allocates every row slot up front
+	 *
+	 * @param rowSize values in every row (at least 1)
+	 * @param minRows rows the buffer must hold, rounded up to a power of two
+	 */
+	SpscRingBuffer(std::size_t rowSize, std::size_t minRows) : rowSize(rowSize > 0 ? rowSize : 1) {
+		std::size_t numRows = 1;
+		while (numRows < minRows) {
+			numRows <<= 1;
+		}
+		mask = numRows - 1;
+		slots.resize(numRows * this->rowSize);
+	}
+
+	SpscRingBuffer(const SpscRingBuffer&) = delete;
+	SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+	/**
+	 * Copies a row into the buffer. Only the producer thread may call this.
+	 *
+	 * @param row values of the row
+	 *
+	 * @return false if the buffer is full (nothing is copied then)
+	 *
+	 * @pre row.size() == GetRowSize()
+	 */
+	bool TryPush(std::span<const T> row) {
+		std::size_t position = tail.load(std::memory_order_relaxed);
+		if (position - head.load(std::memory_order_acquire) > mask) {
+			return false;
+		}
+		T* slot = slots.data() + (position & mask) * rowSize;
+		for (std::size_t i = 0; i < rowSize; i++) {
+			slot[i] = row[i];
+		}
+		tail.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Copies the oldest row out of the buffer. Only the consumer thread may
+	 * call this.
+	 *
+	 * @param row updated with the values of the row
+	 *
+	 * @return false if the buffer is empty (row is left alone then)
+	 *
+	 * @pre row.size() == GetRowSize()
+	 */
+	bool TryPop(std::span<T> row) {
+		std::size_t position = head.load(std::memory_order_relaxed);
+		if (position == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		const T* slot = slots.data() + (position & mask) * rowSize;
+		for (std::size_t i = 0; i < rowSize; i++) {
+			row[i] = slot[i];
+		}
+		head.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::size_t GetRowSize() const { return rowSize; }
+	std::size_t GetCapacity() const { return mask + 1; }
+};
+#endif
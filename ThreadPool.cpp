@@ -0,0 +1,169 @@
+#include "ThreadPool.h"
+
+namespace {
+	thread_local const ThreadPool* currentPool = nullptr; //!< Pool the calling thread works for (nullptr outside a pool)
+	thread_local int currentWorker = -1; //!< Index of the calling thread within currentPool
+}
+
+//--------------------- Private Functions -----------------------//
+
+/**
+ * Takes a task for a worker: the newest task of its own queue, otherwise
+ * the oldest task of the first other queue that has one
+ *
+ * @param worker index of the worker looking for work
+ * @param task updated with the task found
+ *
+ * @return false if every queue was empty
+ */
+bool ThreadPool::TakeTask(int worker, std::function<void()>& task) {
+	{
+		WorkerQueue& own = *queues[worker];
+		std::lock_guard<std::mutex> lock(own.lock);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	int numQueues = queues.size();
+	for (int offset = 1; offset < numQueues; offset++) {
+		WorkerQueue& victim = *queues[(worker + offset) % numQueues];
+		std::lock_guard<std::mutex> lock(victim.lock);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Loop run by every worker: take a task, run it, repeat until stopping
+ *
+ * @param worker index of the worker (and of its queue)
+ */
+void ThreadPool::WorkerLoop(int worker) {
+	currentPool = this;
+	currentWorker = worker;
+
+	while (true) {
+		std::function<void()> task;
+		if (!TakeTask(worker, task)) {
+			std::unique_lock<std::mutex> lock(stateLock);
+			if (stopping && queuedTasks <= 0) {
+				return;
+			}
+			taskReady.wait(lock, [this] { return stopping || queuedTasks > 0; });
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(stateLock);
+			queuedTasks--;
+		}
+
+		//An escaping exception would end the program from this thread, so it is kept for Wait
+		std::exception_ptr error = nullptr;
+		try {
+			task();
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+
+		std::lock_guard<std::mutex> lock(stateLock);
+		if (error != nullptr && firstError == nullptr) {
+			firstError = error;
+		}
+		pendingTasks--;
+		if (pendingTasks == 0) {
+			allDone.notify_all();
+		}
+	}
+}
+
+//--------------------- Public Functions -----------------------//
+
+/**
+ * Starts the worker threads
+ *
+ * @param numThreads number of workers to start (at least 1 is started)
+ */
+ThreadPool::ThreadPool(int numThreads) {
+	if (numThreads < 1) {
+		numThreads = 1;
+	}
+	for (int i = 0; i < numThreads; i++) {
+		queues.push_back(std::make_unique<WorkerQueue>());
+	}
+	for (int i = 0; i < numThreads; i++) {
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+/**
+ * Finishes every queued task and joins the workers
+ */
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(stateLock);
+		stopping = true;
+	}
+	taskReady.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+/**
+ * Queues a task. A task submitted by a worker of this pool goes on that
+ * worker's own queue; other tasks are dealt to the queues in turn.
+ *
+ * @param task work to run
+ */
+void ThreadPool::Submit(std::function<void()> task) {
+	int target = currentPool == this ? currentWorker : nextQueue++ % queues.size();
+	{
+		std::lock_guard<std::mutex> lock(stateLock);
+		queuedTasks++;
+		pendingTasks++;
+	}
+	{
+		WorkerQueue& queue = *queues[target];
+		std::lock_guard<std::mutex> lock(queue.lock);
+		queue.tasks.push_back(std::move(task));
+	}
+	taskReady.notify_one();
+}
+
+/**
+ * Blocks until every submitted task has finished. An exception that
+ * escapes a task does not stop the worker or the other tasks; the first
+ * one is handed back here.
+ *
+ * @throws the first exception a task let escape since the last Wait
+ *
+ * @pre not called from a task of this pool
+ */
+void ThreadPool::Wait() {
+	std::unique_lock<std::mutex> lock(stateLock);
+	allDone.wait(lock, [this] { return pendingTasks == 0; });
+	if (firstError != nullptr) {
+		std::exception_ptr error = firstError;
+		firstError = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+/**
+ * Fetches the number of hardware threads on this machine
+ *
+ * @return the hardware thread count (1 if it cannot be determined)
+ */
+int ThreadPool::HardwareThreads() {
+	int count = std::thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
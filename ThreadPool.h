@@ -0,0 +1,115 @@
+/**
+ * The Thread Pool class keeps a fixed set of worker threads that run
+ * submitted tasks. Every worker owns a queue of tasks; a worker that runs
+ * out of tasks steals the oldest task from another worker, so uneven work
+ * (i.e. large and small files) balances itself out.
+ */
+#ifndef THREAD_POOL_H_INCLUDED
+#define THREAD_POOL_H_INCLUDED
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+private:
+
+	/**
+	 * Tasks owned by one worker. The owner takes from the back (newest first),
+	 * thieves take from the front (oldest first).
+	 */
+	struct WorkerQueue
+	{
+		std::mutex lock; //!< Guards tasks
+		std::deque<std::function<void()>> tasks; //!< Tasks waiting to run
+	};
+
+	std::vector<std::thread> workers = {}; //!< Threads that run the tasks
+	std::vector<std::unique_ptr<WorkerQueue>> queues = {}; //!< One queue per worker
+	std::atomic<unsigned> nextQueue = 0; //!< Queue that receives the next task submitted from outside the pool
+
+	std::mutex stateLock; //!< Guards queuedTasks, pendingTasks, stopping and firstError
+	std::condition_variable taskReady; //!< Signalled when a task is queued or the pool stops
+	std::condition_variable allDone; //!< Signalled when pendingTasks drops to 0
+
+	int queuedTasks = 0; //!< Tasks sitting in a queue
+	int pendingTasks = 0; //!< Tasks submitted but not yet finished
+	bool stopping = false; //!< Set when the pool is being destroyed
+	std::exception_ptr firstError = nullptr; //!< First exception a task let escape since the last Wait
+
+	/**
+	 * Takes a task for a worker: the newest task of its own queue, otherwise
+	 * the oldest task of the first other queue that has one
+	 *
+	 * @param worker index of the worker looking for work
+	 * @param task updated with the task found
+	 *
+	 * @return false if every queue was empty
+	 */
+	bool TakeTask(int worker, std::function<void()>& task);
+
+	/**
+	 * Loop run by every worker: take a task, run it, repeat until stopping
+	 *
+	 * @param worker index of the worker (and of its queue)
+	 */
+	void WorkerLoop(int worker);
+
+public:
+
+	/**
+	 * Starts the worker threads
+	 *
+	 * @param numThreads number of workers to start (at least 1 is started)
+	 */
+	ThreadPool(int numThreads);
+
+	/**
+	 * Finishes every queued task and joins the workers
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * Queues a task. A task submitted by a worker of this pool goes on that
+	 * worker's own queue; other tasks are dealt to the queues in turn.
+	 *
+	 * @param task work to run
+	 */
+	void Submit(std::function<void()> task);
+
+	/**
+	 * Blocks until every submitted task has finished. An exception that
+	 * escapes a task does not stop the worker or the other tasks; the first
+	 * one is handed back here.
+	 *
+	 * @throws the first exception a task let escape since the last Wait
+	 *
+	 * @pre not called from a task of this pool
+	 */
+	void Wait();
+
+	/**
+	 * Fetches how many workers the pool runs
+	 *
+	 * @return the number of worker threads
+	 */
+	int GetNumThreads() const { return workers.size(); }
+
+	/**
+	 * Fetches the number of hardware threads on this machine
+	 *
+	 * @return the hardware thread count (1 if it cannot be determined)
+	 */
+	static int HardwareThreads();
+};
+#endif
@@ -0,0 +1,183 @@
+/**
+ * The Uniform Step Engine is a fast path for logs whose readings are an equal
+ * number of seconds apart, which is every log parse_raw_temps reads. The step
+ * and the core count are template parameters, so:
+ *
+ *   - the time of reading i is worked out as firstTime + i * Step instead of
+ *     being loaded from the time column,
+ *   - every interpolation divides by the same step, so it multiplies by a
+ *     reciprocal fixed at compile time instead,
+ *   - xTx of the least squares approximation depends only on the number of
+ *     readings n. With the times centred on their mean it is diagonal,
+ *     diag(n, Step^2 * n(n^2 - 1) / 12), so it is inverted in closed form and
+ *     only xTy has to be summed, for every core in one pass,
+ *   - the loops over the cores have a fixed trip count the compiler unrolls.
+ *
+ * FindUniformStepEngine picks the instantiation matching a log at runtime.
+ * Logs it has no instantiation for (or irregular times) keep using
+ * PiecewiseLinearInterpolation and LeastSquaresApproximation. Results agree
+ * with those classes to within rounding of the last bits.
+ */
+#ifndef UNIFORM_STEP_ENGINE_H_INCLUDED
+#define UNIFORM_STEP_ENGINE_H_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <utility>
+
+#include "DataPreProcessor.h"
+#include "InterpolationTable.h"
+
+using SlopeAndIntercept = std::pair<double, double>;
+
+constexpr int MAX_UNIFORM_CORES = 16; //!< Highest core count with an instantiation
+constexpr std::array<int, 7> UNIFORM_STEPS = { 1, 2, 5, 10, 15, 30, 60 }; //!< Steps (in seconds) with an instantiation
+
+template<int Step, int Cores>
+class UniformStepEngine
+{
+	static_assert(Step > 0, "the step must be positive");
+	static_assert(Cores > 0, "there must be at least one core");
+
+private:
+
+	static constexpr double STEP_RECIPROCAL = 1.0 / Step; //!< Replaces the division by the time span of each interpolation
+
+public:
+
+	/**
+	 * Calculates the slopes and y-intercepts of every core, like
+	 * PiecewiseLinearInterpolation::Calculate, without reading the times
+	 *
+	 * @param table resized and filled with one column of slopes and y-intercepts per core
+	 * @param data provides the temps of every core
+	 *
+	 * @pre data has Cores cores and its times are firstTime + i * Step
+	 */
+	static void Interpolate(InterpolationTable& table, const DataPreProcessor& data) {
+		std::size_t numReadings = data.GetTimes().size();
+		std::size_t numSegments = numReadings > 1 ? numReadings - 1 : 0;
+		table.Resize(Cores, numSegments);
+		if (numSegments == 0) {
+			return;
+		}
+		double firstTime = data.GetTimes().front();
+
+		for (int core = 0; core < Cores; core++) {
+			const double* temps = data.GetCoreReadings(core).data();
+			double* slopes = table.GetSlopes(core).data();
+			double* yIntercepts = table.GetIntercepts(core).data();
+			for (std::size_t i = 0; i < numSegments; i++) {
+				double slope = (temps[i + 1] - temps[i]) * STEP_RECIPROCAL;
+				slopes[i] = slope;
+				yIntercepts[i] = temps[i] - slope * (firstTime + static_cast<double>(i) * Step);
+			}
+		}
+	}
+
+	/**
+	 * Calculates the slope (c1) and intercept (c0) of the least squares
+	 * approximation of every core, like LeastSquaresApproximation::Calculate,
+	 * without reading the times
+	 *
+	 * @param fits updated with c1 and c0 of every core respectively
+	 * @param data provides the temps of every core
+	 *
+	 * @pre data has Cores cores, fits has room for them and the times are firstTime + i * Step
+	 */
+	static void Fit(std::span<SlopeAndIntercept> fits, const DataPreProcessor& data) {
+		std::size_t numReadings = data.GetTimes().size();
+		if (numReadings == 0) {
+			return;
+		}
+		double firstTime = data.GetTimes().front();
+
+		//Centred on the mean index the times are symmetric, so xTx has no off-diagonal terms
+		double count = static_cast<double>(numReadings);
+		double meanIndex = (count - 1.0) / 2.0;
+		double inverseSpread = numReadings > 1 ? 12.0 / (count * (count * count - 1.0)) : 0.0;
+
+		std::array<const double*, Cores> columns;
+		for (int core = 0; core < Cores; core++) {
+			columns[core] = data.GetCoreReadings(core).data();
+		}
+
+		//xTy of every core in one pass over the readings
+		std::array<double, Cores> sumTemps = {};
+		std::array<double, Cores> sumWeightedTemps = {};
+		for (std::size_t i = 0; i < numReadings; i++) {
+			double weight = static_cast<double>(i) - meanIndex;
+			for (int core = 0; core < Cores; core++) {
+				double temp = columns[core][i];
+				sumTemps[core] += temp;
+				sumWeightedTemps[core] += weight * temp;
+			}
+		}
+
+		for (int core = 0; core < Cores; core++) {
+			double slopePerReading = sumWeightedTemps[core] * inverseSpread;
+			double slope = slopePerReading * STEP_RECIPROCAL;
+			double meanTemp = sumTemps[core] / count;
+			fits[core] = SlopeAndIntercept(slope, meanTemp - slope * (firstTime + meanIndex * Step));
+		}
+	}
+};
+
+/**
+ * The instantiation of UniformStepEngine serving one step and core count
+ */
+struct UniformStepFunctions
+{
+	void (*Interpolate)(InterpolationTable&, const DataPreProcessor&); //!< UniformStepEngine::Interpolate
+	void (*Fit)(std::span<SlopeAndIntercept>, const DataPreProcessor&); //!< UniformStepEngine::Fit
+};
+
+/**
+ * Builds the row of the dispatch table for one step, one entry per core count
+ */
+template<int Step, std::size_t... CoreIndex>
+constexpr std::array<UniformStepFunctions, sizeof...(CoreIndex)> MakeUniformStepRow(std::index_sequence<CoreIndex...>) {
+	return { { { &UniformStepEngine<Step, CoreIndex + 1>::Interpolate, &UniformStepEngine<Step, CoreIndex + 1>::Fit }... } };
+}
+
+/**
+ * Builds the dispatch table, one row per entry of UNIFORM_STEPS
+ */
+template<std::size_t... StepIndex>
+constexpr std::array<std::array<UniformStepFunctions, MAX_UNIFORM_CORES>, sizeof...(StepIndex)> MakeUniformStepTable(std::index_sequence<StepIndex...>) {
+	return { { MakeUniformStepRow<UNIFORM_STEPS[StepIndex]>(std::make_index_sequence<MAX_UNIFORM_CORES>())... } };
+}
+
+/**
+ * Finds the UniformStepEngine instantiation for the step and core count of
+ * some processed data
+ *
+ * @param data provides the times and the number of cores
+ *
+ * @return the engine's functions, nullptr if the times are not evenly spaced
+ *         or no instantiation covers the step and core count
+ */
+inline const UniformStepFunctions* FindUniformStepEngine(const DataPreProcessor& data) {
+	static constexpr auto table = MakeUniformStepTable(std::make_index_sequence<UNIFORM_STEPS.size()>());
+
+	std::span<const int> times = data.GetTimes();
+	int numCores = data.GetNumCores();
+	if (times.size() < 2 || numCores < 1 || numCores > MAX_UNIFORM_CORES) {
+		return nullptr;
+	}
+
+	//The parsers always space the times evenly, so the ends are enough to confirm the step
+	long long step = static_cast<long long>(times[1]) - times[0];
+	if (static_cast<long long>(times.back()) - times.front() != step * static_cast<long long>(times.size() - 1)) {
+		return nullptr;
+	}
+
+	for (std::size_t stepIndex = 0; stepIndex < UNIFORM_STEPS.size(); stepIndex++) {
+		if (UNIFORM_STEPS[stepIndex] == step) {
+			return &table[stepIndex][numCores - 1];
+		}
+	}
+	return nullptr;
+}
+#endif